@@ -4,7 +4,28 @@
 #include <include/libplatform/libplatform.h>
 #include <vector>
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
 #include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <string>
+#include <functional>
+#include <map>
+#include <deque>
+#include <chrono>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
 
 struct RefCounted
 {
@@ -51,12 +72,123 @@ struct ArrayBufferAllocator: v8::ArrayBuffer::Allocator
 };
 
 v8::Platform* _platform = nullptr;
+static std::once_flag _platformInitialized;
+
+// Set by ConfigureJSEngine, and read once when the engine is initialized. The
+// RAIL mode is read by every new context, so it is atomic rather than guarded.
+static std::mutex _engineConfigMutex;
+static bool _engineInitialized = false;
+static std::string _engineFlags;
+static std::atomic<v8::RAILMode> _defaultRAILMode(v8::PERFORMANCE_ANIMATION);
+
+static const char* ProfileFlags(JSEngineProfile profile)
+{
+	switch (profile)
+	{
+		case JSEngineProfile::LowLatency: return "--min_semi_space_size=1 --max_semi_space_size=4";
+		case JSEngineProfile::Throughput: return "--min_semi_space_size=16 --max_semi_space_size=32";
+		case JSEngineProfile::LowMemory: return "--optimize_for_size --max_semi_space_size=1";
+		default: return "";
+	}
+}
+
+// Contexts may be created from several threads at once (e.g. by workers), so
+// the one-time engine setup is guarded.
+static void InitializeV8()
+{
+	std::call_once(_platformInitialized, []
+	{
+		std::lock_guard<std::mutex> lock(_engineConfigMutex);
+		_engineInitialized = true;
+		v8::V8::InitializeICU();
+		// SharedArrayBuffer, Atomics and WebAssembly are still behind flags in
+		// this version
+		static const char flags[] = "--harmony-sharedarraybuffer --expose-wasm";
+		v8::V8::SetFlagsFromString(flags, sizeof(flags) - 1);
+		if (!_engineFlags.empty())
+			v8::V8::SetFlagsFromString(_engineFlags.c_str(), static_cast<int>(_engineFlags.size()));
+		_platform = v8::platform::CreateDefaultPlatform();
+		v8::V8::InitializePlatform(_platform);
+		v8::V8::Initialize();
+	});
+}
+
+static ArrayBufferAllocator _arrayBufferAllocator;
+
+// Storage for a scope object that is only constructed on some code paths.
+template<class T>
+struct Optional
+{
+	typename std::aligned_storage<sizeof(T), alignof(T)>::type _storage;
+	bool _hasValue;
+
+	Optional() : _hasValue(false) { }
+	Optional(const Optional&) = delete;
+	Optional& operator=(const Optional&) = delete;
+
+	template<class... Args>
+	void Emplace(Args&&... args)
+	{
+		new (&_storage) T(std::forward<Args>(args)...);
+		_hasValue = true;
+	}
+
+	~Optional()
+	{
+		if (_hasValue)
+			reinterpret_cast<T*>(&_storage)->~T();
+	}
+};
 
 // Using this and not plain v8::Persistents ensures that the references are
 // reset in the destructor.
 template<class T>
 using ResettingPersistent = v8::Persistent<T, v8::CopyablePersistentTraits<T>>;
 
+struct JSContext;
+
+struct JSSnapshot : RefCounted
+{
+	v8::StartupData Data;
+
+	// Takes ownership of data, which must have been allocated with new[]
+	JSSnapshot(v8::StartupData data) : Data(data) { }
+
+	virtual ~JSSnapshot() override
+	{
+		delete[] Data.data;
+	}
+};
+
+// Every live context, so that memory pressure can be forwarded to all of them
+static std::mutex _contextsMutex;
+static std::vector<JSContext*> _contexts;
+
+// Locks and enters the context's isolate for the duration of the scope.
+// Single-owner contexts are locked and entered once by their owner thread, so
+// there is nothing to do except check that we're on that thread.
+struct IsolateLock
+{
+	IsolateLock(JSContext* context);
+	Optional<v8::Locker> Locker;
+	Optional<v8::Isolate::Scope> IsolateScope;
+};
+
+// Functions created for snapshots call back into the host through this, so
+// it is the one external reference V8 needs to serialize and restore them.
+static void HostCallbackTrampoline(const v8::FunctionCallbackInfo<v8::Value>& info);
+static intptr_t _externalReferences[] =
+{
+	reinterpret_cast<intptr_t>(&HostCallbackTrampoline),
+	0,
+};
+
+// The message of WrongThreadException. Single-owner contexts create it up
+// front as a JSString, since other threads can't create anything in the
+// isolate, and JSStringLength and WriteJSStringBuffer let any thread read it.
+static const char WrongThreadText[] = "Context used from a thread other than its owner";
+static RefCounted* NewWrongThreadMessage(v8::Isolate* isolate);
+
 struct JSContext : RefCounted
 {
 	const JSCallbackFinalizer CallbackFinalizer;
@@ -65,69 +197,334 @@ struct JSContext : RefCounted
 	ResettingPersistent<v8::Context> Handle;
 	JSDebugMessageHandler DebugMessageHandler;
 	void* DebugMessageHandlerData;
+	const bool SingleOwner;
+	const std::thread::id OwnerThread;
+	v8::Locker* OwnerLocker;
+	std::atomic<bool> InBackground;
+	// Work left for the owner of a single-owner context by other threads
+	std::mutex OwnerTasksMutex;
+	std::vector<std::function<void()>> OwnerTasks;
+	std::atomic<bool> HasOwnerTasks;
+	// CPU time accounting. The depths are only touched with the isolate locked
+	std::atomic<bool> CpuAccounting;
+	std::atomic<uint64_t> CpuNanos;
+	std::atomic<uint64_t> HostCpuNanos;
+	int CpuScopeDepth;
+	int HostScopeDepth;
+	JSSnapshot* Snapshot;
+	v8::SnapshotCreator* SnapshotCreator;
+	// Handles kept by the host in a snapshot context, see SnapshotHandle
+	std::atomic<int> SnapshotHandles;
+	// A JSString, only for single-owner contexts
+	RefCounted* WrongThreadMessage;
+	// Data of interrupts that haven't run yet. V8 drops pending interrupts
+	// with the isolate, so whatever is left here is released with the context
+	std::mutex InterruptsMutex;
+	std::vector<RefCounted*> PendingInterrupts;
+
+	// Host functions and objects that can be put in snapshots refer to their
+	// host side by id, which is bound to these per context
+	struct HostCallbackBinding
+	{
+		void* Data;
+		JSCallback Callback;
+	};
+	std::vector<HostCallbackBinding> HostCallbacks;
+	std::vector<void*> HostObjects;
+	ResettingPersistent<v8::ObjectTemplate> HostObjectTemplate;
 
 	JSContext(
 		JSCallbackFinalizer callbackFinalizer,
-		JSExternalFinalizer externalFinalizer)
+		JSExternalFinalizer externalFinalizer,
+		bool singleOwner = false,
+		JSSnapshot* snapshot = nullptr,
+		bool forSnapshot = false)
 		: CallbackFinalizer(callbackFinalizer)
 		, ExternalFinalizer(externalFinalizer)
 		, DebugMessageHandler(nullptr)
 		, DebugMessageHandlerData(nullptr)
+		, SingleOwner(singleOwner)
+		, OwnerThread(std::this_thread::get_id())
+		, OwnerLocker(nullptr)
+		, InBackground(false)
+		, HasOwnerTasks(false)
+		, CpuAccounting(false)
+		, CpuNanos(0)
+		, HostCpuNanos(0)
+		, CpuScopeDepth(0)
+		, HostScopeDepth(0)
+		, Snapshot(snapshot)
+		, SnapshotCreator(nullptr)
+		, SnapshotHandles(0)
+		, WrongThreadMessage(nullptr)
 	{
-		if (_platform == nullptr)
+		InitializeV8();
+
+		v8::Isolate::CreateParams createParams;
+		createParams.array_buffer_allocator = &_arrayBufferAllocator;
+		createParams.external_references = _externalReferences;
+		if (Snapshot != nullptr)
+		{
+			// The blob has to outlive the isolate
+			Snapshot->Retain();
+			createParams.snapshot_blob = &Snapshot->Data;
+		}
+		if (forSnapshot)
+		{
+			// The creator makes its own isolate, and enters it on this thread
+			SnapshotCreator = new v8::SnapshotCreator(_externalReferences);
+			Isolate = SnapshotCreator->GetIsolate();
+		}
+		else
 		{
-			v8::V8::InitializeICU();
-			_platform = v8::platform::CreateDefaultPlatform();
-			v8::V8::InitializePlatform(_platform);
-			v8::V8::Initialize();
+			Isolate = v8::Isolate::New(createParams);
 		}
+		Isolate->SetData(0, this);
+		auto railMode = _defaultRAILMode.load();
+		if (railMode != v8::PERFORMANCE_ANIMATION)
+			Isolate->SetRAILMode(railMode);
 
-		static ArrayBufferAllocator arrayBufferAllocator;
-		v8::Isolate::CreateParams createParams;
-		createParams.array_buffer_allocator = &arrayBufferAllocator;
-		Isolate = v8::Isolate::New(createParams);
+		if (SingleOwner)
+		{
+			OwnerLocker = new v8::Locker(Isolate);
+			Isolate->Enter();
+		}
 
-		v8::Locker locker(Isolate);
-		v8::Isolate::Scope isolateScope(Isolate);
+		IsolateLock lock(this);
 		v8::HandleScope handleScope(Isolate);
 
 		auto localContext = v8::Context::New(Isolate);
 		v8::Context::Scope contextScope(localContext);
 
 		Handle.Reset(Isolate, localContext);
+		if (SingleOwner)
+			WrongThreadMessage = NewWrongThreadMessage(Isolate);
+
+		std::lock_guard<std::mutex> contextsLock(_contextsMutex);
+		_contexts.push_back(this);
 	}
 
 	virtual ~JSContext() override
 	{
+		RunOwnerTasks();
+		if (WrongThreadMessage != nullptr)
+			WrongThreadMessage->Release();
 		auto oldData = DebugMessageHandlerData;
 		DebugMessageHandler = nullptr;
 		DebugMessageHandlerData = nullptr;
 		if (ExternalFinalizer != nullptr && oldData != nullptr)
 			ExternalFinalizer(oldData);
 		Handle.Reset();
+		HostObjectTemplate.Reset();
+		for (auto& binding : HostCallbacks)
+		{
+			if (CallbackFinalizer != nullptr && binding.Data != nullptr)
+				CallbackFinalizer(binding.Data);
+		}
+		for (auto value : HostObjects)
+		{
+			if (ExternalFinalizer != nullptr && value != nullptr)
+				ExternalFinalizer(value);
+		}
+
+		{
+			std::lock_guard<std::mutex> contextsLock(_contextsMutex);
+			_contexts.erase(std::find(_contexts.begin(), _contexts.end(), this));
+		}
 
-		Isolate->Dispose();
+		if (SingleOwner)
+		{
+			Isolate->Exit();
+			delete OwnerLocker;
+			OwnerLocker = nullptr;
+		}
+
+		if (SnapshotCreator != nullptr)
+			delete SnapshotCreator;
+		else
+			Isolate->Dispose();
 		Isolate = nullptr;
+
+		for (auto data : PendingInterrupts)
+			data->Release();
+		PendingInterrupts.clear();
+
+		if (Snapshot != nullptr)
+			Snapshot->Release();
 	}
 
 	inline v8::Local<v8::Context> LocalHandle() { return Handle.Get(Isolate); }
+
+	void RunOwnerTasks()
+	{
+		if (!HasOwnerTasks)
+			return;
+		std::vector<std::function<void()>> tasks;
+		{
+			std::lock_guard<std::mutex> lock(OwnerTasksMutex);
+			tasks.swap(OwnerTasks);
+			HasOwnerTasks = false;
+		}
+		for (auto& task : tasks)
+			task();
+	}
 };
 
-struct V8Scope
+// False for a single-owner context used from a thread other than its owner.
+// Such calls must not touch the isolate, so entry points check this first
+// and fail with JSRuntimeError::WrongThread.
+static bool IsOwnerThread(JSContext* context)
+{
+	return !context->SingleOwner || std::this_thread::get_id() == context->OwnerThread;
+}
+
+// References to single-owner contexts dropped by threads other than their
+// owners. Each owner releases its own the next time it locks one of its
+// contexts, which includes creating a new one.
+static std::mutex _orphansMutex;
+static std::vector<JSContext*> _orphans;
+static std::atomic<bool> _hasOrphans(false);
+
+static void ReleaseOrphans()
+{
+	if (!_hasOrphans)
+		return;
+	std::vector<JSContext*> owned;
+	{
+		std::lock_guard<std::mutex> lock(_orphansMutex);
+		auto self = std::this_thread::get_id();
+		auto it = std::partition(_orphans.begin(), _orphans.end(), [&] (JSContext* context)
+		{
+			return context->OwnerThread != self;
+		});
+		owned.assign(it, _orphans.end());
+		_orphans.erase(it, _orphans.end());
+		_hasOrphans = !_orphans.empty();
+	}
+	for (auto context : owned)
+		context->Release();
+}
+
+IsolateLock::IsolateLock(JSContext* context)
+{
+	if (context->SingleOwner)
+	{
+		if (!IsOwnerThread(context))
+			throw JSRuntimeError::WrongThread;
+		ReleaseOrphans();
+		context->RunOwnerTasks();
+		return;
+	}
+	Locker.Emplace(context->Isolate);
+	IsolateScope.Emplace(context->Isolate);
+}
+
+// Runs release with the isolate locked. For a single-owner context used from
+// another thread, the release is left to the owner, which runs it the next
+// time it locks the context, or when the context is destroyed.
+template<typename F>
+static void ReleaseOnOwnerThread(JSContext* context, F release)
+{
+	if (IsOwnerThread(context))
+	{
+		IsolateLock lock(context);
+		release();
+		return;
+	}
+	std::lock_guard<std::mutex> lock(context->OwnerTasksMutex);
+	context->OwnerTasks.emplace_back(release);
+	context->HasOwnerTasks = true;
+}
+
+static uint64_t ThreadCpuNanos()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+	auto ticks =
+		((static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime)
+		+ ((static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime);
+	return ticks * 100;
+#else
+	timespec time;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+	return static_cast<uint64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+#endif
+}
+
+// Counts a handle kept by the host while it is alive, if the isolate is a
+// snapshot context's. V8 aborts when a snapshot is taken with any such handle
+// left, so CreateJSSnapshotFromContext checks the count first.
+struct SnapshotHandle
 {
-	V8Scope(v8::Isolate* isolate, const ResettingPersistent<v8::Context>& context)
-		: Locker(isolate)
-		, IsolateScope(isolate)
-		, HandleScope(isolate)
-		, ContextScope(context.Get(isolate))
+	std::atomic<int>* Count;
+
+	SnapshotHandle(v8::Isolate* isolate) : Count(nullptr)
+	{
+		auto context = static_cast<JSContext*>(isolate->GetData(0));
+		if (context != nullptr && context->SnapshotCreator != nullptr)
+		{
+			Count = &context->SnapshotHandles;
+			++*Count;
+		}
+	}
+	SnapshotHandle(const SnapshotHandle&) = delete;
+	SnapshotHandle& operator=(const SnapshotHandle&) = delete;
+	~SnapshotHandle()
+	{
+		if (Count != nullptr)
+			--*Count;
+	}
+};
+
+// Adds the thread CPU time spent in the outermost of nested timers sharing a
+// depth to the total, if the context has accounting turned on. Must be used
+// with the isolate locked.
+struct CpuTimer
+{
+	CpuTimer(JSContext* context, int& depth, std::atomic<uint64_t>& total)
+		: Depth(depth)
+		, Total(total)
+		, Start(0)
+	{
+		if (Depth++ == 0 && context->CpuAccounting.load(std::memory_order_relaxed))
+			Start = ThreadCpuNanos();
+	}
+	~CpuTimer()
 	{
+		--Depth;
+		if (Start != 0)
+			Total.fetch_add(ThreadCpuNanos() - Start, std::memory_order_relaxed);
 	}
+	int& Depth;
+	std::atomic<uint64_t>& Total;
+	uint64_t Start;
+};
+
+struct V8Scope
+{
 	V8Scope(JSContext* context)
-		: V8Scope(context->Isolate, context->Handle)
+		: Lock(context)
+		, Timer(context, context->CpuScopeDepth, context->CpuNanos)
+		, HandleScope(context->Isolate)
+		, ContextScope(context->LocalHandle())
+	{
+	}
+	IsolateLock Lock;
+	CpuTimer Timer;
+	v8::HandleScope HandleScope;
+	v8::Context::Scope ContextScope;
+};
+
+// The handle and context scopes of a V8Scope, for code that already holds the
+// isolate lock
+struct EnteredScope
+{
+	EnteredScope(JSContext* context)
+		: HandleScope(context->Isolate)
+		, ContextScope(context->LocalHandle())
 	{
 	}
-	v8::Locker Locker;
-	v8::Isolate::Scope IsolateScope;
 	v8::HandleScope HandleScope;
 	v8::Context::Scope ContextScope;
 };
@@ -154,9 +551,11 @@ struct JSDouble : JSValue
 struct JSString : JSValue
 {
 	virtual JSType Type() const override { return JSType::String; }
+	const SnapshotHandle Tracked;
 	const ResettingPersistent<v8::String> Handle;
 	JSString(v8::Isolate* isolate, const v8::Local<v8::String>& handle)
-		: Handle(isolate, handle)
+		: Tracked(isolate)
+		, Handle(isolate, handle)
 	{
 	}
 	inline v8::Local<v8::String> LocalHandle(v8::Isolate* isolate) { return Handle.Get(isolate); }
@@ -173,21 +572,37 @@ struct JSBool : JSValue
 struct JSObject : JSValue
 {
 	virtual JSType Type() const override { return JSType::Object; }
+	const SnapshotHandle Tracked;
 	const ResettingPersistent<v8::Object> Handle;
 	JSObject(v8::Isolate* isolate, const v8::Local<v8::Object>& handle)
-		: Handle(isolate, handle)
+		: Tracked(isolate)
+		, Handle(isolate, handle)
 	{
 	}
 	inline v8::Local<v8::Object> LocalHandle(v8::Isolate* isolate) { return Handle.Get(isolate); }
 	inline v8::Local<v8::Object> LocalHandle(JSContext* context) { return Handle.Get(context->Isolate); }
 };
 
+struct JSMap : JSObject
+{
+	virtual JSType Type() const override { return JSType::Map; }
+	JSMap(v8::Isolate* isolate, const v8::Local<v8::Map>& handle) : JSObject(isolate, handle) { }
+};
+
+struct JSSet : JSObject
+{
+	virtual JSType Type() const override { return JSType::Set; }
+	JSSet(v8::Isolate* isolate, const v8::Local<v8::Set>& handle) : JSObject(isolate, handle) { }
+};
+
 struct JSArray : JSValue
 {
 	virtual JSType Type() const override { return JSType::Array; }
+	const SnapshotHandle Tracked;
 	ResettingPersistent<v8::Array> Handle;
 	JSArray(v8::Isolate* isolate, const v8::Local<v8::Array>& handle)
-		: Handle(isolate, handle)
+		: Tracked(isolate)
+		, Handle(isolate, handle)
 	{
 	}
 	inline v8::Local<v8::Array> LocalHandle(v8::Isolate* isolate) { return Handle.Get(isolate); }
@@ -197,9 +612,11 @@ struct JSArray : JSValue
 struct JSFunction : JSValue
 {
 	virtual JSType Type() const override { return JSType::Function; }
+	const SnapshotHandle Tracked;
 	ResettingPersistent<v8::Function> Handle;
 	JSFunction(v8::Isolate* isolate, const v8::Local<v8::Function>& handle)
-		: Handle(isolate, handle)
+		: Tracked(isolate)
+		, Handle(isolate, handle)
 	{
 	}
 	inline v8::Local<v8::Function> LocalHandle(v8::Isolate* isolate) { return Handle.Get(isolate); }
@@ -209,9 +626,11 @@ struct JSFunction : JSValue
 struct JSExternal : JSValue
 {
 	virtual JSType Type() const override { return JSType::External; }
+	const SnapshotHandle Tracked;
 	ResettingPersistent<v8::External> Handle;
 	JSExternal(v8::Isolate* isolate, const v8::Local<v8::External>& handle)
-		: Handle(isolate, handle)
+		: Tracked(isolate)
+		, Handle(isolate, handle)
 	{
 	}
 	inline v8::Local<v8::External> LocalHandle(v8::Isolate* isolate) { return Handle.Get(isolate); }
@@ -254,10 +673,26 @@ struct JSScriptException : RefCounted
 	}
 };
 
-template<typename T>
+static RefCounted* NewWrongThreadMessage(v8::Isolate* isolate)
+{
+	return new JSString(isolate, v8::String::NewFromUtf8(isolate, WrongThreadText));
+}
+
+// Reported instead of a script error when a single-owner context is used from
+// a thread other than its owner. Only its message is set, see WrongThreadText.
+static JSScriptException* WrongThreadException(JSContext* context)
+{
+	auto message = static_cast<JSString*>(context->WrongThreadMessage);
+	if (message != nullptr)
+		message->Retain();
+	return new JSScriptException(nullptr, message, nullptr, -1, nullptr, nullptr);
+}
+
+// scope is a V8Scope, or an EnteredScope where the lock is already held
+template<typename T, typename Scope>
 inline static auto TryCatch(
 	JSScriptException** outError,
-	const V8Scope& scope,
+	const Scope& scope,
 	T inner) -> decltype(inner((v8::TryCatch&)*(v8::TryCatch*)nullptr))
 {
 	*outError = nullptr;
@@ -279,6 +714,11 @@ inline static auto TryCatch(
 	JSContext* context,
 	T inner) -> decltype(inner((v8::TryCatch&)*(v8::TryCatch*)nullptr))
 {
+	if (!IsOwnerThread(context))
+	{
+		*outError = WrongThreadException(context);
+		return decltype(inner((v8::TryCatch&)*(v8::TryCatch*)nullptr))();
+	}
 	V8Scope scope(context);
 	return TryCatch(outError, scope, inner);
 }
@@ -374,6 +814,10 @@ static JSValue* Wrap(JSContext* context, const v8::TryCatch& tryCatch, v8::Local
 		return new JSFunction(context->Isolate, FromJust(context, tryCatch, value->ToObject(context->LocalHandle())).As<v8::Function>());
 	if (value->IsExternal())
 		return new JSExternal(context->Isolate, value.As<v8::External>());
+	if (value->IsMap())
+		return new JSMap(context->Isolate, value.As<v8::Map>());
+	if (value->IsSet())
+		return new JSSet(context->Isolate, value.As<v8::Set>());
 	if (value->IsObject())
 		return new JSObject(context->Isolate, FromJust(context, tryCatch, value->ToObject(context->LocalHandle())));
 	return nullptr; // TODO do something good here
@@ -400,6 +844,8 @@ static v8::Local<v8::Value> Unwrap(v8::Isolate* isolate, JSValue* value)
 		case JSType::External:
 			return static_cast<JSExternal*>(value)->LocalHandle(isolate);
 		case JSType::Object:
+		case JSType::Map:
+		case JSType::Set:
 			return static_cast<JSObject*>(value)->LocalHandle(isolate);
 		default: break;
 	}
@@ -427,535 +873,4514 @@ inline static T* data_ptr(std::vector<T>& v)
 		: nullptr;
 }
 
-// -------------------------------------------------------------------------
-// Context
-DllPublic void CDecl RetainJSContext(JSContext* context)
+// Lock-free multi-producer, single-consumer queue (Vyukov's intrusive queue).
+// Push may be called from any thread; Pop and IsEmpty only from the consumer.
+template<typename T>
+class MPSCQueue
 {
-	if (context != nullptr)
+	struct Node
 	{
-		context->Retain();
+		std::atomic<Node*> Next;
+		T Value;
+		Node() : Next(nullptr) { }
+	};
+
+	std::atomic<Node*> _head;
+	Node* _tail;
+
+public:
+	MPSCQueue()
+	{
+		auto stub = new Node();
+		_head = stub;
+		_tail = stub;
 	}
-}
 
-DllPublic void CDecl ReleaseJSContext(JSContext* context)
-{
-	if (context != nullptr)
+	MPSCQueue(const MPSCQueue&) = delete;
+	MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+	~MPSCQueue()
 	{
-		v8::Locker(context->Isolate);
-		context->Release();
+		T value;
+		while (Pop(value)) { }
+		delete _tail;
 	}
-}
 
-DllPublic JSContext* CDecl CreateJSContext(
-	JSCallbackFinalizer callbackFinalizer,
-	JSExternalFinalizer externalFinalizer)
-{
-	return new JSContext(callbackFinalizer, externalFinalizer);
-}
+	void Push(T value)
+	{
+		auto node = new Node();
+		node->Value = std::move(value);
+		auto prev = _head.exchange(node);
+		prev->Next.store(node, std::memory_order_release);
+	}
 
-DllPublic JSValue* CDecl JSContextEvaluateCreate(JSContext* context, JSString* fileName, JSString* code, JSScriptException** outError)
-{
-	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	bool Pop(T& outValue)
 	{
-		v8::ScriptOrigin origin(fileName->LocalHandle(context));
-		auto script = FromJust(
-			context,
-			tryCatch,
-			v8::Script::Compile(
-				context->LocalHandle(),
-				code->LocalHandle(context),
-				&origin));
+		auto tail = _tail;
+		auto next = tail->Next.load(std::memory_order_acquire);
+		if (next == nullptr)
+			return false;
+		outValue = std::move(next->Value);
+		_tail = next;
+		delete tail;
+		return true;
+	}
 
-		return WrapMaybe(context, tryCatch, script->Run(context->LocalHandle()));
-	});
-}
+	bool IsEmpty() const
+	{
+		return _tail->Next.load() == nullptr;
+	}
+};
 
-DllPublic JSObject* CDecl JSContextCopyGlobalObject(JSContext* context)
+// Lets a consumer thread sleep until a producer has queued something. Only
+// sleeping and waking take the mutex; Notify is a single atomic load while the
+// consumer is busy.
+class WakeSignal
 {
-	V8Scope scope(context);
-	return new JSObject(context->Isolate, context->LocalHandle()->Global());
-}
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	std::atomic<bool> _sleeping;
+	bool _signalled;
 
-DllPublic const char* CDecl GetV8Version() { return v8::V8::GetVersion(); }
+public:
+	WakeSignal() : _sleeping(false), _signalled(false) { }
 
-// -------------------------------------------------------------------------
-// Debug
-DllPublic void CDecl SetJSDebugMessageHandler(JSContext* context, void* data, JSDebugMessageHandler messageHandler)
-{
-	static JSContext* debugContext;
-	debugContext = context;
-	if (context->DebugMessageHandlerData != data || context->DebugMessageHandler != messageHandler)
+	// Call after making the work visible.
+	void Notify()
 	{
-		V8Scope scope(context);
-		auto oldData = context->DebugMessageHandlerData;
-
-		if (messageHandler == nullptr)
+		// Pairs with the fence in Wait: either this sees the waiter going to
+		// sleep, or the waiter's hasWork() sees the work. Without it the work's
+		// store and this load can be reordered, and the wakeup lost.
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (_sleeping.load())
 		{
-			context->DebugMessageHandler = nullptr;
-			context->DebugMessageHandlerData = nullptr;
-			v8::Debug::SetMessageHandler(context->Isolate, nullptr);
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_signalled = true;
+			}
+			_condition.notify_one();
 		}
-		else
+	}
+
+	// Sleeps unless hasWork() already holds, and until Notify is called.
+	template<typename F>
+	void Wait(F hasWork)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_sleeping.store(true);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!hasWork())
 		{
-			context->DebugMessageHandlerData = data;
-			context->DebugMessageHandler = messageHandler;
-			v8::Debug::SetMessageHandler(context->Isolate, [] (const v8::Debug::Message& message)
-			{
-				auto isolate = message.GetIsolate();
-				v8::HandleScope handleScope(isolate);
-				debugContext->DebugMessageHandler(debugContext->DebugMessageHandlerData, new JSString(isolate, message.GetJSON()));
-			});
+			_condition.wait(lock, [this] { return _signalled; });
 		}
-		if (context->ExternalFinalizer != nullptr && oldData != nullptr)
-			context->ExternalFinalizer(oldData);
+		_signalled = false;
+		_sleeping.store(false);
 	}
-}
+};
 
-DllPublic void CDecl SendJSDebugCommand(JSContext* context, const uint16_t* command, int length)
+// A value serialized with the structured clone algorithm, along with the
+// contents of any ArrayBuffers that were transferred rather than copied.
+// Transferred contents are owned by this object until they are adopted by a
+// deserializing isolate.
+struct SerializedValue
 {
-	v8::Debug::SendCommand(context->Isolate, command, length);
-}
+	struct Contents
+	{
+		void* Data;
+		size_t ByteLength;
+	};
 
-DllPublic void CDecl ProcessJSDebugMessages(JSContext* context)
-{
-	V8Scope scope(context);
-	v8::Debug::ProcessDebugMessages(context->Isolate);
-}
+	std::vector<uint8_t> Data;
+	std::vector<Contents> ArrayBuffers;
 
-// -------------------------------------------------------------------------
-// Value
-DllPublic JSType CDecl GetJSValueType(JSValue* value) { return value == nullptr ? JSType::Null : value->Type(); }
-DllPublic void CDecl RetainJSValue(JSContext* context, JSValue* value)
+	SerializedValue() { }
+	SerializedValue(const SerializedValue&) = delete;
+	SerializedValue& operator=(const SerializedValue&) = delete;
+
+	~SerializedValue()
+	{
+		for (auto& contents : ArrayBuffers)
+			_arrayBufferAllocator.Free(contents.Data, contents.ByteLength);
+	}
+};
+
+// Embedder hooks for the objects that the serializer can't clone by itself,
+// i.e. those with internal fields. The writer turns such an object into an id
+// and the reader turns the id back into an object.
+struct HostObjectHooks
 {
-	if (value != nullptr)
-		value->Retain();
-}
-DllPublic void CDecl ReleaseJSValue(JSContext* context, JSValue* value)
+	JSContext* Context;
+	void* Data;
+	JSHostObjectWriter Writer;
+	JSHostObjectReader Reader;
+};
+
+struct SerializerDelegate : v8::ValueSerializer::Delegate
 {
-	if (value != nullptr && context != nullptr)
+	v8::Isolate* const Isolate;
+	const HostObjectHooks* const Hooks;
+	v8::ValueSerializer* Serializer;
+
+	SerializerDelegate(v8::Isolate* isolate, const HostObjectHooks* hooks)
+		: Isolate(isolate)
+		, Hooks(hooks)
+		, Serializer(nullptr)
 	{
-		v8::Locker(context->Isolate);
-		value->Release();
 	}
-	else
+
+	virtual void ThrowDataCloneError(v8::Local<v8::String> message) override
 	{
-		// Leak
+		Isolate->ThrowException(v8::Exception::Error(message));
 	}
-}
 
-DllPublic int CDecl JSValueAsInt(JSValue* value, JSRuntimeError* outError)
-{
-	*outError = JSRuntimeError::NoError;
-	if (GetJSValueType(value) != JSType::Int)
+	virtual v8::Maybe<bool> WriteHostObject(v8::Isolate* isolate, v8::Local<v8::Object> object) override
 	{
-		*outError = JSRuntimeError::InvalidCast;
-		return 0;
+		if (Hooks == nullptr || Hooks->Writer == nullptr)
+			return v8::ValueSerializer::Delegate::WriteHostObject(isolate, object);
+
+		uint64_t id = 0;
+		auto wrapped = new JSObject(isolate, object);
+		auto written = Hooks->Writer(Hooks->Data, Hooks->Context, wrapped, &id);
+		wrapped->Release();
+		if (!written)
+		{
+			ThrowDataCloneError(v8::String::NewFromUtf8(isolate, "Host object could not be cloned"));
+			return v8::Nothing<bool>();
+		}
+		Serializer->WriteUint64(id);
+		return v8::Just(true);
 	}
-	return static_cast<JSInt*>(value)->Value;
-}
+};
 
-DllPublic double CDecl JSValueAsDouble(JSValue* value, JSRuntimeError* outError)
+struct DeserializerDelegate : v8::ValueDeserializer::Delegate
 {
-	*outError = JSRuntimeError::NoError;
-	if (GetJSValueType(value) != JSType::Double)
+	const HostObjectHooks* const Hooks;
+	v8::ValueDeserializer* Deserializer;
+
+	DeserializerDelegate(const HostObjectHooks* hooks)
+		: Hooks(hooks)
+		, Deserializer(nullptr)
 	{
-		*outError = JSRuntimeError::InvalidCast;
-		return 0.0;
 	}
-	return static_cast<JSDouble*>(value)->Value;
-}
 
-DllPublic JSString* CDecl JSValueAsString(JSValue* value, JSRuntimeError* outError)
-{
-	*outError = JSRuntimeError::NoError;
-	if (GetJSValueType(value) != JSType::String)
+	virtual v8::MaybeLocal<v8::Object> ReadHostObject(v8::Isolate* isolate) override
 	{
-		*outError = JSRuntimeError::InvalidCast;
-		return nullptr;
+		if (Hooks == nullptr || Hooks->Reader == nullptr)
+			return v8::ValueDeserializer::Delegate::ReadHostObject(isolate);
+
+		uint64_t id;
+		JSObject* object = nullptr;
+		if (Deserializer->ReadUint64(&id))
+			object = Hooks->Reader(Hooks->Data, Hooks->Context, id);
+		if (object == nullptr)
+		{
+			isolate->ThrowException(v8::Exception::Error(
+				v8::String::NewFromUtf8(isolate, "Host object could not be read")));
+			return v8::MaybeLocal<v8::Object>();
+		}
+		auto result = object->LocalHandle(isolate);
+		object->Release();
+		return result;
 	}
-	return static_cast<JSString*>(value);
-}
+};
 
-DllPublic bool CDecl JSValueAsBool(JSValue* value, JSRuntimeError* outError)
+// Returns false with an exception pending on the isolate on failure. The
+// ArrayBuffers in transferList (which may be empty) are neutered on success.
+// hooks may be null, in which case host objects can't be cloned.
+static bool Serialize(
+	v8::Isolate* isolate,
+	v8::Local<v8::Context> context,
+	v8::Local<v8::Value> value,
+	v8::Local<v8::Array> transferList,
+	SerializedValue& out,
+	const HostObjectHooks* hooks = nullptr)
 {
-	*outError = JSRuntimeError::NoError;
-	if (GetJSValueType(value) != JSType::Bool)
+	SerializerDelegate delegate(isolate, hooks);
+	v8::ValueSerializer serializer(isolate, &delegate);
+	delegate.Serializer = &serializer;
+
+	std::vector<v8::Local<v8::ArrayBuffer>> transferred;
+	if (!transferList.IsEmpty())
 	{
-		*outError = JSRuntimeError::InvalidCast;
+		for (uint32_t i = 0; i < transferList->Length(); ++i)
+		{
+			v8::Local<v8::Value> item;
+			if (!transferList->Get(context, i).ToLocal(&item))
+				return false;
+			if (!item->IsArrayBuffer() || !item.As<v8::ArrayBuffer>()->IsNeuterable())
+			{
+				isolate->ThrowException(v8::Exception::TypeError(
+					v8::String::NewFromUtf8(isolate, "Transfer list items must be neuterable ArrayBuffers")));
+				return false;
+			}
+			serializer.TransferArrayBuffer(static_cast<uint32_t>(transferred.size()), item.As<v8::ArrayBuffer>());
+			transferred.push_back(item.As<v8::ArrayBuffer>());
+		}
+	}
+
+	serializer.WriteHeader();
+	if (serializer.WriteValue(context, value).IsNothing())
 		return false;
+	out.Data = serializer.ReleaseBuffer();
+
+	for (auto arrayBuffer : transferred)
+	{
+		SerializedValue::Contents contents;
+		if (arrayBuffer->IsExternal())
+		{
+			// The embedder owns the memory, so the receiver gets a copy
+			auto external = arrayBuffer->GetContents();
+			contents.ByteLength = external.ByteLength();
+			contents.Data = _arrayBufferAllocator.AllocateUninitialized(contents.ByteLength);
+			memcpy(contents.Data, external.Data(), contents.ByteLength);
+		}
+		else
+		{
+			auto externalized = arrayBuffer->Externalize();
+			contents.Data = externalized.Data();
+			contents.ByteLength = externalized.ByteLength();
+		}
+		arrayBuffer->Neuter();
+		out.ArrayBuffers.push_back(contents);
 	}
-	return static_cast<JSBool*>(value)->Value;
+	return true;
 }
 
-DllPublic JSObject* CDecl JSValueAsObject(JSValue* value, JSRuntimeError* outError)
+// Returns an empty handle with an exception pending on the isolate on failure.
+// Takes ownership of in's transferred ArrayBuffers.
+static v8::MaybeLocal<v8::Value> Deserialize(
+	v8::Isolate* isolate,
+	v8::Local<v8::Context> context,
+	SerializedValue& in,
+	const HostObjectHooks* hooks = nullptr)
 {
-	*outError = JSRuntimeError::NoError;
-	auto type = GetJSValueType(value);
-	if (type != JSType::Object && type != JSType::Null)
+	DeserializerDelegate delegate(hooks);
+	v8::ValueDeserializer deserializer(isolate, data_ptr(in.Data), in.Data.size(), &delegate);
+	delegate.Deserializer = &deserializer;
+
+	for (size_t i = 0; i < in.ArrayBuffers.size(); ++i)
 	{
-		*outError = JSRuntimeError::InvalidCast;
-		return nullptr;
+		deserializer.TransferArrayBuffer(
+			static_cast<uint32_t>(i),
+			v8::ArrayBuffer::New(
+				isolate,
+				in.ArrayBuffers[i].Data,
+				in.ArrayBuffers[i].ByteLength,
+				v8::ArrayBufferCreationMode::kInternalized));
 	}
-	return static_cast<JSObject*>(value);
+	in.ArrayBuffers.clear();
+
+	if (deserializer.ReadHeader(context).IsNothing())
+		return v8::MaybeLocal<v8::Value>();
+	return deserializer.ReadValue(context);
 }
 
-DllPublic JSArray* CDecl JSValueAsArray(JSValue* value, JSRuntimeError* outError)
+// The typed getters share everything but how the property is looked up and
+// how the value is unboxed.
+template<typename T, typename Get, typename Convert>
+static T GetTypedProperty(
+	JSContext* context,
+	JSRuntimeError* outError,
+	JSScriptException** outScriptError,
+	Get get,
+	Convert convert)
 {
-	*outError = JSRuntimeError::NoError;
-	if (GetJSValueType(value) != JSType::Array)
+	*outError = IsOwnerThread(context) ? JSRuntimeError::NoError : JSRuntimeError::WrongThread;
+	return TryCatch(outScriptError, context, [&] (v8::TryCatch& tryCatch)
 	{
-		*outError = JSRuntimeError::InvalidCast;
-		return nullptr;
-	}
-	return static_cast<JSArray*>(value);
+		T result = T();
+		if (!convert(FromJust(context, tryCatch, get()), result))
+			*outError = JSRuntimeError::InvalidCast;
+		return result;
+	});
 }
 
-DllPublic JSFunction* CDecl JSValueAsFunction(JSValue* value, JSRuntimeError* outError)
+static bool ToDouble(v8::Local<v8::Value> value, double& result)
 {
-	*outError = JSRuntimeError::NoError;
-	if (GetJSValueType(value) != JSType::Function)
-	{
-		*outError = JSRuntimeError::InvalidCast;
-		return nullptr;
-	}
-	return static_cast<JSFunction*>(value);
+	if (!value->IsNumber())
+		return false;
+	result = value.As<v8::Number>()->Value();
+	return true;
 }
 
-DllPublic JSExternal* CDecl JSValueAsExternal(JSValue* value, JSRuntimeError* outError)
+static bool ToInt(v8::Local<v8::Value> value, int& result)
 {
-	*outError = JSRuntimeError::NoError;
-	if (GetJSValueType(value) != JSType::External)
+	if (!value->IsInt32())
+		return false;
+	result = value.As<v8::Int32>()->Value();
+	return true;
+}
+
+static bool ToBool(v8::Local<v8::Value> value, bool& result)
+{
+	if (!value->IsBoolean())
+		return false;
+	result = value->IsTrue();
+	return true;
+}
+
+// Returns the length of the string; it's only written if it fits.
+static int WriteStringProperty(v8::Local<v8::Value> value, uint16_t* outBuffer, int bufferLength, JSRuntimeError* outError)
+{
+	if (!value->IsString())
 	{
 		*outError = JSRuntimeError::InvalidCast;
-		return nullptr;
+		return 0;
 	}
-	return static_cast<JSExternal*>(value);
+	auto string = value.As<v8::String>();
+	auto length = string->Length();
+	if (length <= bufferLength)
+		string->Write(outBuffer, 0, length, v8::String::NO_NULL_TERMINATION);
+	return length;
 }
 
-DllPublic bool CDecl JSValueStrictEquals(JSContext* context, JSValue* obj1, JSValue* obj2)
+template<typename Set>
+static void SetTypedProperty(JSContext* context, JSScriptException** outError, Set set)
 {
-	V8Scope scope(context);
-	return Unwrap(context->Isolate, obj1)->StrictEquals(Unwrap(context->Isolate, obj2));
+	TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		FromJust(context, tryCatch, set(tryCatch));
+	});
 }
 
-// --------------------------------------------------------------------------
-// Primitives
-DllPublic JSValue* CDecl JSNull() { return nullptr; }
-DllPublic JSValue* CDecl CreateJSInt(int value) { return new JSInt(value); }
-DllPublic JSValue* CDecl CreateJSDouble(double value) { return new JSDouble(value); }
-DllPublic JSValue* CDecl CreateJSBool(bool value) { return new JSBool(value); }
-
-DllPublic JSObject* CDecl CreateExternalJSArrayBuffer(JSContext* context, void* data, int byteLength)
+static v8::Local<v8::Value> NewUtf8String(JSContext* context, const v8::TryCatch& tryCatch, const char* value, int length)
 {
-	V8Scope scope(context);
-	return new JSObject(context->Isolate, v8::ArrayBuffer::New(context->Isolate, data, (size_t)byteLength));
+	return FromJust(context, tryCatch, v8::String::NewFromUtf8(context->Isolate, value, v8::NewStringType::kNormal, length));
 }
 
-DllPublic JSFunction* CDecl CreateJSCallback(JSContext* context, void* data, JSCallback callback, JSScriptException** outError)
+struct AutoReleaser
 {
-	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	const std::vector<JSValue*>& _values;
+
+	~AutoReleaser()
 	{
-		struct Closure
+		for (auto v : _values)
 		{
-			JSContext* context;
-			ResettingPersistent<v8::External> finalizer;
-			void* data;
-			JSCallback callback;
-		};
-		auto closure = new Closure{context, {}, data, callback};
+			if (v != nullptr)
+				v->Release();
+		}
+	}
+};
 
-		auto localClosure = v8::External::New(context->Isolate, closure);
-		closure->finalizer.Reset(context->Isolate, localClosure);
+static void InvokeHostCallback(
+	const v8::FunctionCallbackInfo<v8::Value>& info,
+	JSContext* context,
+	void* data,
+	JSCallback callback)
+{
+	auto isolate = info.GetIsolate();
+	v8::HandleScope handleScope(isolate);
 
-		closure->finalizer.SetWeak(
-			closure,
-			[] (const v8::WeakCallbackInfo<Closure>& data)
-			{
-				auto closure = data.GetParameter();
-				auto f = closure->context->CallbackFinalizer;
-				if (f != nullptr)
-					f(closure->data);
-				closure->finalizer.Reset();
-				delete closure;
-			},
-			v8::WeakCallbackType::kParameter);
+	auto numArgs = info.Length();
+	std::vector<JSValue*> args(numArgs);
+	AutoReleaser autoRelease{args};
 
-		struct AutoReleaser
+	try
+	{
 		{
-			const std::vector<JSValue*>& _values;
+			v8::TryCatch tryCatch;
+			for (int i = 0; i < numArgs; ++i)
+				args[i] = Wrap(context, tryCatch, info[i]);
+		}
 
-			~AutoReleaser()
-			{
-				for (auto v : _values)
-				{
-					if (v != nullptr)
-						v->Release();
-				}
-			}
-		};
+		JSValue* error = nullptr;
+		JSValue* result;
+		{
+			CpuTimer timer(context, context->HostScopeDepth, context->HostCpuNanos);
+			result = callback(context, data, data_ptr(args), numArgs, &error);
+		}
 
-		return new JSFunction(context->Isolate,
-			FromJust(context, tryCatch, v8::Function::New(
-				context->LocalHandle(),
-				[] (const v8::FunctionCallbackInfo<v8::Value>& info)
-				{
-					auto isolate = info.GetIsolate();
-					v8::HandleScope handleScope(isolate);
-					Closure* closure =
-						static_cast<Closure*>(info.Data().
-							As<v8::External>()
-							->Value());
+		info.GetReturnValue().Set(Unwrap(isolate, result));
 
-					auto numArgs = info.Length();
-					std::vector<JSValue*> args(numArgs);
-					AutoReleaser autoRelease{args};
-
-					try
-					{
-						{
-							v8::TryCatch tryCatch;
-							for (int i = 0; i < numArgs; ++i)
-								args[i] = Wrap(closure->context, tryCatch, info[i]);
-						}
-
-						JSValue* error = nullptr;
-						JSValue* result = closure->callback(closure->context, closure->data, data_ptr(args), numArgs, &error);
-
-						info.GetReturnValue().Set(Unwrap(isolate, result));
-
-						if (result != nullptr)
-							result->Release();
-
-						if (error != nullptr)
-						{
-							auto unwrappedError = Unwrap(isolate, error);
-							error->Release();
-							isolate->ThrowException(unwrappedError);
-						}
-					}
-					catch (JSScriptException* error)
-					{
-						auto unwrappedError = Unwrap(isolate, error->Exception);
-						error->Release();
-						isolate->ThrowException(unwrappedError);
-					}
-				},
-				localClosure.As<v8::Value>())));
-	});
+		if (result != nullptr)
+			result->Release();
+
+		if (error != nullptr)
+		{
+			auto unwrappedError = Unwrap(isolate, error);
+			error->Release();
+			isolate->ThrowException(unwrappedError);
+		}
+	}
+	catch (JSScriptException* error)
+	{
+		auto unwrappedError = Unwrap(isolate, error->Exception);
+		error->Release();
+		isolate->ThrowException(unwrappedError);
+	}
 }
 
-// --------------------------------------------------------------------------
-// String
-DllPublic JSString* CDecl CreateJSString(JSContext* context, const uint16_t* buffer, int length, JSRuntimeError* outError)
+// -------------------------------------------------------------------------
+// Context
+DllPublic void CDecl RetainJSContext(JSContext* context)
 {
-	*outError = JSRuntimeError::NoError;
-	V8Scope scope(context);
-	auto mstr = v8::String::NewFromTwoByte(context->Isolate, buffer, v8::NewStringType::kNormal, length);
-	if (mstr.IsEmpty())
+	if (context != nullptr)
 	{
-		*outError = JSRuntimeError::StringTooLong;
-		return nullptr;
+		context->Retain();
 	}
-	return new JSString(context->Isolate, mstr.ToLocalChecked());
 }
 
-DllPublic int CDecl JSStringLength(JSContext* context, JSString* string)
+DllPublic void CDecl ReleaseJSContext(JSContext* context)
 {
-	V8Scope scope(context);
-	return string->LocalHandle(context)->Length();
+	if (context == nullptr)
+		return;
+	if (!IsOwnerThread(context))
+	{
+		// Only the owner can destroy a single-owner context, so other threads
+		// may only drop references that aren't the last. The last is left for
+		// the owner, see ReleaseOrphans.
+		auto refCount = context->_refCount.load();
+		while (refCount > 1)
+		{
+			if (context->_refCount.compare_exchange_weak(refCount, refCount - 1))
+				return;
+		}
+		std::lock_guard<std::mutex> lock(_orphansMutex);
+		_orphans.push_back(context);
+		_hasOrphans = true;
+		return;
+	}
+	context->Release();
 }
 
-DllPublic void CDecl WriteJSStringBuffer(JSContext* context, JSString* string, uint16_t* outBuffer, bool nullTerminate)
+DllPublic JSContext* CDecl CreateJSContext(
+	JSCallbackFinalizer callbackFinalizer,
+	JSExternalFinalizer externalFinalizer)
 {
-	V8Scope scope(context);
-	string->LocalHandle(context)->Write(outBuffer, 0, -1, nullTerminate ? v8::String::NO_OPTIONS : v8::String::NO_NULL_TERMINATION);
+	return new JSContext(callbackFinalizer, externalFinalizer);
 }
 
-DllPublic JSValue* CDecl JSStringAsValue(JSString* string) { return static_cast<JSValue*>(string); }
+DllPublic JSContext* CDecl CreateJSContextSingleOwner(
+	JSCallbackFinalizer callbackFinalizer,
+	JSExternalFinalizer externalFinalizer)
+{
+	return new JSContext(callbackFinalizer, externalFinalizer, true);
+}
 
-// -------------------------------------------------------------------------
-// Object
-DllPublic JSValue* CDecl CopyJSObjectProperty(JSContext* context, JSObject* obj, JSString* key, JSScriptException** outError)
+DllPublic JSContext* CDecl CreateJSContextFromSnapshot(
+	JSCallbackFinalizer callbackFinalizer,
+	JSExternalFinalizer externalFinalizer,
+	JSSnapshot* snapshot)
+{
+	return new JSContext(callbackFinalizer, externalFinalizer, false, snapshot);
+}
+
+DllPublic JSValue* CDecl JSContextEvaluateCreate(JSContext* context, JSString* fileName, JSString* code, JSScriptException** outError)
 {
 	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
 	{
-		return WrapMaybe(
+		v8::ScriptOrigin origin(fileName->LocalHandle(context));
+		auto script = FromJust(
 			context,
 			tryCatch,
-			obj->LocalHandle(context)->Get(
+			v8::Script::Compile(
 				context->LocalHandle(),
-				key->LocalHandle(context)));
+				code->LocalHandle(context),
+				&origin));
+
+		return WrapMaybe(context, tryCatch, script->Run(context->LocalHandle()));
 	});
 }
 
-DllPublic void CDecl SetJSObjectProperty(JSContext* context, JSObject* obj, JSString* key, JSValue* value, JSScriptException** outError)
+DllPublic int CDecl JSContextEvaluateBatch(JSContext* context, const uint16_t* const* fileNames, const uint16_t* const* codes, int count, bool continueOnError, JSScriptException** outErrors)
 {
-	TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	if (count < 0)
+		return -2;
+	std::fill(outErrors, outErrors + count, nullptr);
+	if (!IsOwnerThread(context))
 	{
-		FromJust(context, tryCatch, obj->LocalHandle(context)->Set(
-			context->LocalHandle(),
-			key->LocalHandle(context),
-			Unwrap(context->Isolate, value)));
-	});
+		if (count > 0)
+			outErrors[0] = WrongThreadException(context);
+		return count > 0 ? 0 : -1;
+	}
+	V8Scope scope(context);
+	auto localContext = context->LocalHandle();
+	int firstError = -1;
+	for (int i = 0; i < count; ++i)
+	{
+		v8::HandleScope handleScope(context->Isolate);
+		auto succeeded = TryCatch(&outErrors[i], scope, [&] (v8::TryCatch& tryCatch)
+		{
+			auto fileName = FromJust(context, tryCatch, v8::String::NewFromTwoByte(
+				context->Isolate,
+				fileNames[i],
+				v8::NewStringType::kNormal));
+			auto code = FromJust(context, tryCatch, v8::String::NewFromTwoByte(
+				context->Isolate,
+				codes[i],
+				v8::NewStringType::kNormal));
+			v8::ScriptOrigin origin(fileName);
+			auto script = FromJust(context, tryCatch, v8::Script::Compile(localContext, code, &origin));
+			FromJust(context, tryCatch, script->Run(localContext));
+			return true;
+		});
+		if (!succeeded)
+		{
+			if (firstError < 0)
+				firstError = i;
+			if (!continueOnError)
+				break;
+		}
+	}
+	return firstError;
 }
 
-DllPublic JSArray* CDecl CopyJSObjectOwnPropertyNames(JSContext* context, JSObject* obj, JSScriptException** outError)
+DllPublic JSObject* CDecl JSContextCopyGlobalObject(JSContext* context, JSRuntimeError* outError)
 {
-	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
 	{
-		return new JSArray(
-			context->Isolate,
-			FromJust(
-				context,
-				tryCatch,
-				obj->LocalHandle(context)->GetOwnPropertyNames(context->LocalHandle())));
-	});
+		*outError = JSRuntimeError::WrongThread;
+		return nullptr;
+	}
+	V8Scope scope(context);
+	return new JSObject(context->Isolate, context->LocalHandle()->Global());
 }
 
-DllPublic bool CDecl JSObjectHasProperty(JSContext* context, JSObject* obj, JSString* key, JSScriptException** outError)
+DllPublic bool CDecl ConfigureJSEngine(JSEngineProfile profile, const char* flags)
 {
-	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
-	{
-		return FromJust(
-			context,
-			tryCatch,
-			obj->LocalHandle(context)->Has(context->LocalHandle(), key->LocalHandle(context)));
-	});
+	std::lock_guard<std::mutex> lock(_engineConfigMutex);
+	if (_engineInitialized)
+		return false;
+	_engineFlags = ProfileFlags(profile);
+	if (flags != nullptr)
+		_engineFlags.append(" ").append(flags);
+	_defaultRAILMode = profile == JSEngineProfile::Throughput
+		? v8::PERFORMANCE_LOAD
+		: v8::PERFORMANCE_ANIMATION;
+	return true;
 }
 
-DllPublic void* CDecl GetJSObjectArrayBufferData(JSContext* context, JSObject* obj, JSRuntimeError* outError)
+DllPublic void CDecl SetJSContextRAILMode(JSContext* context, JSRAILMode mode, JSRuntimeError* outError)
 {
 	*outError = JSRuntimeError::NoError;
-	V8Scope scope(context);
-	auto localObj = obj->LocalHandle(context);
-	if (!localObj->IsArrayBuffer())
+	if (!IsOwnerThread(context))
 	{
-		*outError = JSRuntimeError::TypeError;
-		return nullptr;
+		*outError = JSRuntimeError::WrongThread;
+		return;
+	}
+	IsolateLock lock(context);
+	switch (mode)
+	{
+		case JSRAILMode::Response: context->Isolate->SetRAILMode(v8::PERFORMANCE_RESPONSE); break;
+		case JSRAILMode::Animation: context->Isolate->SetRAILMode(v8::PERFORMANCE_ANIMATION); break;
+		case JSRAILMode::Idle: context->Isolate->SetRAILMode(v8::PERFORMANCE_IDLE); break;
+		case JSRAILMode::Load: context->Isolate->SetRAILMode(v8::PERFORMANCE_LOAD); break;
 	}
-	return localObj.As<v8::ArrayBuffer>()->GetContents().Data();
 }
 
-DllPublic JSValue* CDecl JSObjectAsValue(JSObject* obj) { return static_cast<JSValue*>(obj); }
+static v8::MemoryPressureLevel ToMemoryPressureLevel(JSMemoryPressure level)
+{
+	switch (level)
+	{
+		case JSMemoryPressure::Moderate: return v8::MemoryPressureLevel::kModerate;
+		case JSMemoryPressure::Critical: return v8::MemoryPressureLevel::kCritical;
+		default: return v8::MemoryPressureLevel::kNone;
+	}
+}
 
-// -------------------------------------------------------------------------
-// Array
-DllPublic JSValue* CDecl CopyJSArrayPropertyAtIndex(JSContext* context, JSArray* arr, int index, JSScriptException** outError)
+DllPublic void CDecl SetJSContextInBackground(JSContext* context, bool inBackground, JSRuntimeError* outError)
 {
-	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
 	{
-		return WrapMaybe(
-			context,
-			tryCatch,
-			arr->LocalHandle(context)->Get(context->LocalHandle(), index));
-	});
+		*outError = JSRuntimeError::WrongThread;
+		return;
+	}
+	IsolateLock lock(context);
+	context->InBackground = inBackground;
+	if (inBackground)
+	{
+		context->Isolate->IsolateInBackgroundNotification();
+		context->Isolate->MemoryPressureNotification(v8::MemoryPressureLevel::kModerate);
+	}
+	else
+	{
+		context->Isolate->IsolateInForegroundNotification();
+		context->Isolate->MemoryPressureNotification(v8::MemoryPressureLevel::kNone);
+	}
 }
 
-DllPublic void CDecl SetJSArrayPropertyAtIndex(JSContext* context, JSArray* arr, int index, JSValue* value, JSScriptException** outError)
+DllPublic void CDecl NotifyJSContextMemoryPressure(JSContext* context, JSMemoryPressure level)
 {
-	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	context->Isolate->MemoryPressureNotification(ToMemoryPressureLevel(level));
+}
+
+DllPublic void CDecl NotifyJSMemoryPressure(JSMemoryPressure level)
+{
+	std::lock_guard<std::mutex> contextsLock(_contextsMutex);
+	for (auto context : _contexts)
 	{
-		FromJust(
-			context,
-			tryCatch,
-			arr->LocalHandle(context)->Set(
-				context->LocalHandle(),
-				static_cast<uint32_t>(index),
-				Unwrap(context->Isolate, value)));
-	});
+		auto contextLevel = level;
+		if (context->InBackground && level != JSMemoryPressure::None)
+			contextLevel = JSMemoryPressure::Critical;
+		context->Isolate->MemoryPressureNotification(ToMemoryPressureLevel(contextLevel));
+	}
 }
 
-DllPublic int CDecl JSArrayLength(JSContext* context, JSArray* arr)
+DllPublic void CDecl SetJSContextCpuAccounting(JSContext* context, bool enabled)
 {
-	V8Scope scope(context);
-	return static_cast<int>(arr->LocalHandle(context)->Length());
+	context->CpuAccounting = enabled;
 }
 
-DllPublic JSValue* CDecl JSArrayAsValue(JSArray* arr) { return static_cast<JSValue*>(arr); }
+DllPublic uint64_t CDecl GetJSContextCpuTime(JSContext* context)
+{
+	return context->CpuNanos.load(std::memory_order_relaxed);
+}
+
+DllPublic uint64_t CDecl GetJSContextHostCpuTime(JSContext* context)
+{
+	return context->HostCpuNanos.load(std::memory_order_relaxed);
+}
+
+DllPublic void CDecl ResetJSContextCpuTime(JSContext* context)
+{
+	context->CpuNanos = 0;
+	context->HostCpuNanos = 0;
+}
+
+DllPublic const char* CDecl GetV8Version() { return v8::V8::GetVersion(); }
 
 // -------------------------------------------------------------------------
-// Function
-DllPublic JSValue* CDecl CallJSFunctionCreate(JSContext* context, JSFunction* function, JSObject* thisObject, JSValue* const* args, int numArgs, JSScriptException** outError)
+// Snapshots
+DllPublic JSSnapshot* CDecl CreateJSSnapshot(const char* embeddedSource)
 {
-	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	InitializeV8();
+	auto data = v8::V8::CreateSnapshotDataBlob(embeddedSource);
+	return data.data == nullptr ? nullptr : new JSSnapshot(data);
+}
+
+DllPublic JSSnapshot* CDecl WarmUpJSSnapshot(JSSnapshot* coldSnapshot, const char* warmupSource)
+{
+	InitializeV8();
+	auto data = v8::V8::WarmUpSnapshotDataBlob(coldSnapshot->Data, warmupSource);
+	return data.data == nullptr ? nullptr : new JSSnapshot(data);
+}
+
+DllPublic JSSnapshot* CDecl CreateJSSnapshotFromData(const void* data, int length)
+{
+	auto copy = new char[length];
+	memcpy(copy, data, length);
+	v8::StartupData startupData;
+	startupData.data = copy;
+	startupData.raw_size = length;
+	return new JSSnapshot(startupData);
+}
+
+DllPublic void CDecl RetainJSSnapshot(JSSnapshot* snapshot) { snapshot->Retain(); }
+DllPublic void CDecl ReleaseJSSnapshot(JSSnapshot* snapshot) { snapshot->Release(); }
+DllPublic const void* CDecl GetJSSnapshotData(JSSnapshot* snapshot) { return snapshot->Data.data; }
+DllPublic int CDecl GetJSSnapshotLength(JSSnapshot* snapshot) { return snapshot->Data.raw_size; }
+
+DllPublic bool CDecl WriteJSWarmSnapshotFile(const char* embeddedSource, const char* warmupSource, const char* path)
+{
+	auto cold = CreateJSSnapshot(embeddedSource);
+	if (cold == nullptr)
+		return false;
+	auto warm = WarmUpJSSnapshot(cold, warmupSource);
+	cold->Release();
+	if (warm == nullptr)
+		return false;
+
+	auto file = fopen(path, "wb");
+	auto written = file != nullptr
+		&& fwrite(warm->Data.data, 1, warm->Data.raw_size, file) == static_cast<size_t>(warm->Data.raw_size);
+	if (file != nullptr && fclose(file) != 0)
+		written = false;
+	warm->Release();
+	return written;
+}
+
+static void HostCallbackTrampoline(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+	auto isolate = info.GetIsolate();
+	auto context = static_cast<JSContext*>(isolate->GetData(0));
+	auto id = info.Data().As<v8::Uint32>()->Value();
+	if (id >= context->HostCallbacks.size() || context->HostCallbacks[id].Callback == nullptr)
 	{
-		std::vector<v8::Local<v8::Value>> unwrappedArgs(numArgs);
+		char message[64];
+		snprintf(message, sizeof(message), "Host function %u is not bound", id);
+		isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, message)));
+		return;
+	}
+	auto& binding = context->HostCallbacks[id];
+	InvokeHostCallback(info, context, binding.Data, binding.Callback);
+}
 
-		for (int i = 0; i < numArgs; ++i)
-			unwrappedArgs[i] = Unwrap(context->Isolate, args[i]);
+// Host objects have two internal fields: a tag telling them apart from other
+// objects with internal fields, and their id. Both are Smis, which is what
+// lets them be serialized.
+static const int HostObjectTag = 0x4853;
 
-		return WrapMaybe(
-			context,
-			tryCatch,
-			function->LocalHandle(context)->Call(
-				context->LocalHandle(),
-				Unwrap(context->Isolate, thisObject),
-				numArgs,
-				data_ptr(unwrappedArgs)));
+static bool HostObjectId(v8::Local<v8::Object> obj, uint32_t& outId)
+{
+	if (obj->InternalFieldCount() != 2)
+		return false;
+	auto tag = obj->GetInternalField(0);
+	auto id = obj->GetInternalField(1);
+	if (!tag->IsInt32() || tag.As<v8::Int32>()->Value() != HostObjectTag || !id->IsUint32())
+		return false;
+	outId = id.As<v8::Uint32>()->Value();
+	return true;
+}
 
-	});
+DllPublic JSContext* CDecl CreateJSSnapshotContext(JSCallbackFinalizer callbackFinalizer, JSExternalFinalizer externalFinalizer)
+{
+	return new JSContext(callbackFinalizer, externalFinalizer, true, nullptr, true);
 }
 
-DllPublic JSObject* CDecl ConstructJSFunctionCreate(JSContext* context, JSFunction* function, JSValue* const* args, int numArgs, JSScriptException** outError)
+DllPublic JSSnapshot* CDecl CreateJSSnapshotFromContext(JSContext* context, bool keepCompiledCode, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return nullptr;
+	}
+	if (context->SnapshotCreator == nullptr)
+		return nullptr;
+	{
+		V8Scope scope(context);
+		// Let go of callbacks and externals that script can no longer reach,
+		// then refuse rather than let V8 abort on the handles that are left
+		context->Isolate->LowMemoryNotification();
+		// The context's own wrong-thread message is dropped too, unless an
+		// exception still holds it
+		auto message = context->WrongThreadMessage;
+		if (message != nullptr && message->_refCount > 1)
+			return nullptr;
+		if (context->SnapshotHandles > (message != nullptr ? 1 : 0))
+			return nullptr;
+		if (message != nullptr)
+		{
+			context->WrongThreadMessage = nullptr;
+			message->Release();
+		}
+		context->SnapshotCreator->AddContext(context->LocalHandle());
+	}
+	// The creator has the only handles it needs; ours would be serialized
+	context->Handle.Reset();
+	context->HostObjectTemplate.Reset();
+	auto data = context->SnapshotCreator->CreateBlob(keepCompiledCode
+		? v8::SnapshotCreator::FunctionCodeHandling::kKeep
+		: v8::SnapshotCreator::FunctionCodeHandling::kClear);
+	return data.data == nullptr ? nullptr : new JSSnapshot(data);
+}
+
+DllPublic JSFunction* CDecl CreateJSHostFunction(JSContext* context, uint32_t id, JSScriptException** outError)
 {
 	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
 	{
-		std::vector<v8::Local<v8::Value>> unwrappedArgs(numArgs);
+		return new JSFunction(context->Isolate,
+			FromJust(context, tryCatch, v8::Function::New(
+				context->LocalHandle(),
+				HostCallbackTrampoline,
+				v8::Integer::NewFromUnsigned(context->Isolate, id))));
+	});
+}
 
-		for (int i = 0; i < numArgs; ++i)
-			unwrappedArgs[i] = Unwrap(context->Isolate, args[i]);
+DllPublic void CDecl BindJSHostFunction(JSContext* context, uint32_t id, void* data, JSCallback callback, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return;
+	}
+	IsolateLock lock(context);
+	auto& bindings = context->HostCallbacks;
+	if (id >= bindings.size())
+		bindings.resize(id + 1, JSContext::HostCallbackBinding{nullptr, nullptr});
+	auto oldData = bindings[id].Data;
+	bindings[id] = JSContext::HostCallbackBinding{data, callback};
+	if (context->CallbackFinalizer != nullptr && oldData != nullptr && oldData != data)
+		context->CallbackFinalizer(oldData);
+}
 
-		return new JSObject(
-			context->Isolate,
-			FromJust(context, tryCatch, function->LocalHandle(context)->NewInstance(
-				context->LocalHandle(),
-				numArgs,
-				data_ptr(unwrappedArgs))));
+DllPublic JSObject* CDecl CreateJSHostObject(JSContext* context, uint32_t id, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		if (context->HostObjectTemplate.IsEmpty())
+		{
+			auto objectTemplate = v8::ObjectTemplate::New(context->Isolate);
+			objectTemplate->SetInternalFieldCount(2);
+			context->HostObjectTemplate.Reset(context->Isolate, objectTemplate);
+		}
+		auto obj = FromJust(context, tryCatch, context->HostObjectTemplate.Get(context->Isolate)->NewInstance(context->LocalHandle()));
+		obj->SetInternalField(0, v8::Integer::New(context->Isolate, HostObjectTag));
+		obj->SetInternalField(1, v8::Integer::NewFromUnsigned(context->Isolate, id));
+		return new JSObject(context->Isolate, obj);
 	});
 }
 
-DllPublic JSValue* CDecl JSFunctionAsValue(JSFunction* fun) { return static_cast<JSValue*>(fun); }
+DllPublic void CDecl BindJSHostObject(JSContext* context, uint32_t id, void* value, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return;
+	}
+	IsolateLock lock(context);
+	auto& bindings = context->HostObjects;
+	if (id >= bindings.size())
+		bindings.resize(id + 1, nullptr);
+	auto oldValue = bindings[id];
+	bindings[id] = value;
+	if (context->ExternalFinalizer != nullptr && oldValue != nullptr && oldValue != value)
+		context->ExternalFinalizer(oldValue);
+}
 
-// -------------------------------------------------------------------------
-// External
-DllPublic JSExternal* CDecl CreateJSExternal(JSContext* context, void* value)
+DllPublic uint32_t CDecl GetJSHostObjectId(JSContext* context, JSObject* obj, JSRuntimeError* outError)
 {
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return 0;
+	}
 	V8Scope scope(context);
+	uint32_t id = 0;
+	if (!HostObjectId(obj->LocalHandle(context), id))
+		*outError = JSRuntimeError::TypeError;
+	return id;
+}
 
-	auto localExternal = v8::External::New(context->Isolate, value);
-
-	struct Closure
+DllPublic void* CDecl GetJSHostObjectValue(JSContext* context, JSObject* obj, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
 	{
-		ResettingPersistent<v8::External> finalizer;
-		JSExternalFinalizer externalFinalizer;
-		void* value;
-	};
+		*outError = JSRuntimeError::WrongThread;
+		return nullptr;
+	}
+	V8Scope scope(context);
+	uint32_t id = 0;
+	if (!HostObjectId(obj->LocalHandle(context), id))
+	{
+		*outError = JSRuntimeError::TypeError;
+		return nullptr;
+	}
+	return id < context->HostObjects.size() ? context->HostObjects[id] : nullptr;
+}
 
-	auto closure = new Closure{{}, context->ExternalFinalizer, value};
-	closure->finalizer.Reset(context->Isolate, localExternal);
+// -------------------------------------------------------------------------
+// Debug
+DllPublic void CDecl SetJSDebugMessageHandler(JSContext* context, void* data, JSDebugMessageHandler messageHandler, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return;
+	}
+	static JSContext* debugContext;
+	debugContext = context;
+	if (context->DebugMessageHandlerData != data || context->DebugMessageHandler != messageHandler)
+	{
+		V8Scope scope(context);
+		auto oldData = context->DebugMessageHandlerData;
 
-	closure->finalizer.SetWeak(
-		closure,
-		[] (const v8::WeakCallbackInfo<Closure>& data)
+		if (messageHandler == nullptr)
 		{
-			auto closure = data.GetParameter();
-			if (closure->externalFinalizer != nullptr)
-				closure->externalFinalizer(closure->value);
-			closure->finalizer.Reset();
-			delete closure;
-		},
-		v8::WeakCallbackType::kParameter);
+			context->DebugMessageHandler = nullptr;
+			context->DebugMessageHandlerData = nullptr;
+			v8::Debug::SetMessageHandler(context->Isolate, nullptr);
+		}
+		else
+		{
+			context->DebugMessageHandlerData = data;
+			context->DebugMessageHandler = messageHandler;
+			v8::Debug::SetMessageHandler(context->Isolate, [] (const v8::Debug::Message& message)
+			{
+				auto isolate = message.GetIsolate();
+				v8::HandleScope handleScope(isolate);
+				debugContext->DebugMessageHandler(debugContext->DebugMessageHandlerData, new JSString(isolate, message.GetJSON()));
+			});
+		}
+		if (context->ExternalFinalizer != nullptr && oldData != nullptr)
+			context->ExternalFinalizer(oldData);
+	}
+}
 
-	return new JSExternal(context->Isolate, localExternal);
+DllPublic void CDecl SendJSDebugCommand(JSContext* context, const uint16_t* command, int length)
+{
+	v8::Debug::SendCommand(context->Isolate, command, length);
 }
 
-DllPublic void* CDecl GetJSExternalValue(JSContext* context, JSExternal* external)
+DllPublic void CDecl ProcessJSDebugMessages(JSContext* context, JSRuntimeError* outError)
 {
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return;
+	}
 	V8Scope scope(context);
-	return external->LocalHandle(context)->Value();
+	v8::Debug::ProcessDebugMessages(context->Isolate);
 }
 
-DllPublic JSValue* CDecl JSExternalAsValue(JSExternal* external) { return static_cast<JSValue*>(external); }
+// -------------------------------------------------------------------------
+// Value
+DllPublic JSType CDecl GetJSValueType(JSValue* value) { return value == nullptr ? JSType::Null : value->Type(); }
+DllPublic void CDecl RetainJSValue(JSContext* context, JSValue* value)
+{
+	if (value != nullptr)
+		value->Retain();
+}
+DllPublic void CDecl ReleaseJSValue(JSContext* context, JSValue* value)
+{
+	if (value != nullptr && context != nullptr)
+	{
+		ReleaseOnOwnerThread(context, [value] { value->Release(); });
+	}
+	else
+	{
+		// Leak
+	}
+}
+
+DllPublic int CDecl JSValueAsInt(JSValue* value, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (GetJSValueType(value) != JSType::Int)
+	{
+		*outError = JSRuntimeError::InvalidCast;
+		return 0;
+	}
+	return static_cast<JSInt*>(value)->Value;
+}
+
+DllPublic double CDecl JSValueAsDouble(JSValue* value, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (GetJSValueType(value) != JSType::Double)
+	{
+		*outError = JSRuntimeError::InvalidCast;
+		return 0.0;
+	}
+	return static_cast<JSDouble*>(value)->Value;
+}
+
+DllPublic JSString* CDecl JSValueAsString(JSValue* value, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (GetJSValueType(value) != JSType::String)
+	{
+		*outError = JSRuntimeError::InvalidCast;
+		return nullptr;
+	}
+	return static_cast<JSString*>(value);
+}
+
+DllPublic bool CDecl JSValueAsBool(JSValue* value, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (GetJSValueType(value) != JSType::Bool)
+	{
+		*outError = JSRuntimeError::InvalidCast;
+		return false;
+	}
+	return static_cast<JSBool*>(value)->Value;
+}
+
+DllPublic JSObject* CDecl JSValueAsObject(JSValue* value, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	auto type = GetJSValueType(value);
+	if (type != JSType::Object && type != JSType::Map && type != JSType::Set && type != JSType::Null)
+	{
+		*outError = JSRuntimeError::InvalidCast;
+		return nullptr;
+	}
+	return static_cast<JSObject*>(value);
+}
+
+DllPublic JSArray* CDecl JSValueAsArray(JSValue* value, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (GetJSValueType(value) != JSType::Array)
+	{
+		*outError = JSRuntimeError::InvalidCast;
+		return nullptr;
+	}
+	return static_cast<JSArray*>(value);
+}
+
+DllPublic JSFunction* CDecl JSValueAsFunction(JSValue* value, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (GetJSValueType(value) != JSType::Function)
+	{
+		*outError = JSRuntimeError::InvalidCast;
+		return nullptr;
+	}
+	return static_cast<JSFunction*>(value);
+}
+
+DllPublic JSExternal* CDecl JSValueAsExternal(JSValue* value, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (GetJSValueType(value) != JSType::External)
+	{
+		*outError = JSRuntimeError::InvalidCast;
+		return nullptr;
+	}
+	return static_cast<JSExternal*>(value);
+}
+
+DllPublic bool CDecl JSValueStrictEquals(JSContext* context, JSValue* obj1, JSValue* obj2, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return false;
+	}
+	V8Scope scope(context);
+	return Unwrap(context->Isolate, obj1)->StrictEquals(Unwrap(context->Isolate, obj2));
+}
+
+// --------------------------------------------------------------------------
+// Primitives
+DllPublic JSValue* CDecl JSNull() { return nullptr; }
+DllPublic JSValue* CDecl CreateJSInt(int value) { return new JSInt(value); }
+DllPublic JSValue* CDecl CreateJSDouble(double value) { return new JSDouble(value); }
+DllPublic JSValue* CDecl CreateJSBool(bool value) { return new JSBool(value); }
+
+DllPublic JSObject* CDecl CreateExternalJSArrayBuffer(JSContext* context, void* data, int byteLength, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return nullptr;
+	}
+	V8Scope scope(context);
+	return new JSObject(context->Isolate, v8::ArrayBuffer::New(context->Isolate, data, (size_t)byteLength));
+}
+
+DllPublic JSObject* CDecl CreateExternalJSSharedArrayBuffer(JSContext* context, void* data, int byteLength, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return nullptr;
+	}
+	V8Scope scope(context);
+	return new JSObject(context->Isolate, v8::SharedArrayBuffer::New(context->Isolate, data, (size_t)byteLength));
+}
+
+DllPublic JSFunction* CDecl CreateJSCallback(JSContext* context, void* data, JSCallback callback, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		struct Closure
+		{
+			JSContext* context;
+			ResettingPersistent<v8::External> finalizer;
+			void* data;
+			JSCallback callback;
+			SnapshotHandle tracked;
+		};
+		auto closure = new Closure{context, {}, data, callback, {context->Isolate}};
+
+		auto localClosure = v8::External::New(context->Isolate, closure);
+		closure->finalizer.Reset(context->Isolate, localClosure);
+
+		closure->finalizer.SetWeak(
+			closure,
+			[] (const v8::WeakCallbackInfo<Closure>& data)
+			{
+				auto closure = data.GetParameter();
+				auto f = closure->context->CallbackFinalizer;
+				if (f != nullptr)
+					f(closure->data);
+				closure->finalizer.Reset();
+				delete closure;
+			},
+			v8::WeakCallbackType::kParameter);
+
+		return new JSFunction(context->Isolate,
+			FromJust(context, tryCatch, v8::Function::New(
+				context->LocalHandle(),
+				[] (const v8::FunctionCallbackInfo<v8::Value>& info)
+				{
+					Closure* closure =
+						static_cast<Closure*>(info.Data().
+							As<v8::External>()
+							->Value());
+					InvokeHostCallback(info, closure->context, closure->data, closure->callback);
+				},
+				localClosure.As<v8::Value>())));
+	});
+}
+
+// --------------------------------------------------------------------------
+// String
+DllPublic JSString* CDecl CreateJSString(JSContext* context, const uint16_t* buffer, int length, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return nullptr;
+	}
+	V8Scope scope(context);
+	auto mstr = v8::String::NewFromTwoByte(context->Isolate, buffer, v8::NewStringType::kNormal, length);
+	if (mstr.IsEmpty())
+	{
+		*outError = JSRuntimeError::StringTooLong;
+		return nullptr;
+	}
+	return new JSString(context->Isolate, mstr.ToLocalChecked());
+}
+
+DllPublic int CDecl JSStringLength(JSContext* context, JSString* string, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		if (string == context->WrongThreadMessage)
+			return static_cast<int>(sizeof(WrongThreadText) - 1);
+		*outError = JSRuntimeError::WrongThread;
+		return 0;
+	}
+	V8Scope scope(context);
+	return string->LocalHandle(context)->Length();
+}
+
+DllPublic void CDecl WriteJSStringBuffer(JSContext* context, JSString* string, uint16_t* outBuffer, bool nullTerminate, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		if (string == context->WrongThreadMessage)
+			std::copy(WrongThreadText, WrongThreadText + sizeof(WrongThreadText) - (nullTerminate ? 0 : 1), outBuffer);
+		else
+			*outError = JSRuntimeError::WrongThread;
+		return;
+	}
+	V8Scope scope(context);
+	string->LocalHandle(context)->Write(outBuffer, 0, -1, nullTerminate ? v8::String::NO_OPTIONS : v8::String::NO_NULL_TERMINATION);
+}
+
+DllPublic JSValue* CDecl JSStringAsValue(JSString* string) { return static_cast<JSValue*>(string); }
+
+// -------------------------------------------------------------------------
+// Object
+DllPublic JSValue* CDecl CopyJSObjectProperty(JSContext* context, JSObject* obj, JSString* key, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return WrapMaybe(
+			context,
+			tryCatch,
+			obj->LocalHandle(context)->Get(
+				context->LocalHandle(),
+				key->LocalHandle(context)));
+	});
+}
+
+DllPublic void CDecl SetJSObjectProperty(JSContext* context, JSObject* obj, JSString* key, JSValue* value, JSScriptException** outError)
+{
+	TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		FromJust(context, tryCatch, obj->LocalHandle(context)->Set(
+			context->LocalHandle(),
+			key->LocalHandle(context),
+			Unwrap(context->Isolate, value)));
+	});
+}
+
+DllPublic void CDecl SetJSObjectPropertyDouble(JSContext* context, JSObject* obj, JSString* key, double value, JSScriptException** outError)
+{
+	SetTypedProperty(context, outError, [&] (const v8::TryCatch& tryCatch)
+	{
+		return obj->LocalHandle(context)->Set(context->LocalHandle(), key->LocalHandle(context), v8::Number::New(context->Isolate, value));
+	});
+}
+
+DllPublic void CDecl SetJSObjectPropertyInt(JSContext* context, JSObject* obj, JSString* key, int value, JSScriptException** outError)
+{
+	SetTypedProperty(context, outError, [&] (const v8::TryCatch& tryCatch)
+	{
+		return obj->LocalHandle(context)->Set(context->LocalHandle(), key->LocalHandle(context), v8::Integer::New(context->Isolate, value));
+	});
+}
+
+DllPublic void CDecl SetJSObjectPropertyBool(JSContext* context, JSObject* obj, JSString* key, bool value, JSScriptException** outError)
+{
+	SetTypedProperty(context, outError, [&] (const v8::TryCatch& tryCatch)
+	{
+		return obj->LocalHandle(context)->Set(context->LocalHandle(), key->LocalHandle(context), v8::Boolean::New(context->Isolate, value));
+	});
+}
+
+DllPublic void CDecl SetJSObjectPropertyUtf8(JSContext* context, JSObject* obj, JSString* key, const char* value, int length, JSScriptException** outError)
+{
+	SetTypedProperty(context, outError, [&] (const v8::TryCatch& tryCatch)
+	{
+		return obj->LocalHandle(context)->Set(context->LocalHandle(), key->LocalHandle(context), NewUtf8String(context, tryCatch, value, length));
+	});
+}
+
+DllPublic JSArray* CDecl CopyJSObjectOwnPropertyNames(JSContext* context, JSObject* obj, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return new JSArray(
+			context->Isolate,
+			FromJust(
+				context,
+				tryCatch,
+				obj->LocalHandle(context)->GetOwnPropertyNames(context->LocalHandle())));
+	});
+}
+
+DllPublic bool CDecl JSObjectHasProperty(JSContext* context, JSObject* obj, JSString* key, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return FromJust(
+			context,
+			tryCatch,
+			obj->LocalHandle(context)->Has(context->LocalHandle(), key->LocalHandle(context)));
+	});
+}
+
+DllPublic void* CDecl GetJSObjectArrayBufferData(JSContext* context, JSObject* obj, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return nullptr;
+	}
+	V8Scope scope(context);
+	auto localObj = obj->LocalHandle(context);
+	if (localObj->IsSharedArrayBuffer())
+		return localObj.As<v8::SharedArrayBuffer>()->GetContents().Data();
+	if (!localObj->IsArrayBuffer())
+	{
+		*outError = JSRuntimeError::TypeError;
+		return nullptr;
+	}
+	return localObj.As<v8::ArrayBuffer>()->GetContents().Data();
+}
+
+DllPublic double CDecl GetJSObjectPropertyAsDouble(JSContext* context, JSObject* obj, JSString* key, JSRuntimeError* outError, JSScriptException** outScriptError)
+{
+	return GetTypedProperty<double>(context, outError, outScriptError,
+		[&] { return obj->LocalHandle(context)->Get(context->LocalHandle(), key->LocalHandle(context)); },
+		ToDouble);
+}
+
+DllPublic int CDecl GetJSObjectPropertyAsInt(JSContext* context, JSObject* obj, JSString* key, JSRuntimeError* outError, JSScriptException** outScriptError)
+{
+	return GetTypedProperty<int>(context, outError, outScriptError,
+		[&] { return obj->LocalHandle(context)->Get(context->LocalHandle(), key->LocalHandle(context)); },
+		ToInt);
+}
+
+DllPublic bool CDecl GetJSObjectPropertyAsBool(JSContext* context, JSObject* obj, JSString* key, JSRuntimeError* outError, JSScriptException** outScriptError)
+{
+	return GetTypedProperty<bool>(context, outError, outScriptError,
+		[&] { return obj->LocalHandle(context)->Get(context->LocalHandle(), key->LocalHandle(context)); },
+		ToBool);
+}
+
+DllPublic int CDecl GetJSObjectPropertyAsString(JSContext* context, JSObject* obj, JSString* key, uint16_t* outBuffer, int bufferLength, JSRuntimeError* outError, JSScriptException** outScriptError)
+{
+	return GetTypedProperty<int>(context, outError, outScriptError,
+		[&] { return obj->LocalHandle(context)->Get(context->LocalHandle(), key->LocalHandle(context)); },
+		[&] (v8::Local<v8::Value> value, int& result)
+		{
+			result = WriteStringProperty(value, outBuffer, bufferLength, outError);
+			return true;
+		});
+}
+
+DllPublic JSValue* CDecl JSObjectAsValue(JSObject* obj) { return static_cast<JSValue*>(obj); }
+
+// -------------------------------------------------------------------------
+// Array
+DllPublic JSValue* CDecl CopyJSArrayPropertyAtIndex(JSContext* context, JSArray* arr, int index, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return WrapMaybe(
+			context,
+			tryCatch,
+			arr->LocalHandle(context)->Get(context->LocalHandle(), index));
+	});
+}
+
+DllPublic void CDecl SetJSArrayPropertyAtIndex(JSContext* context, JSArray* arr, int index, JSValue* value, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		FromJust(
+			context,
+			tryCatch,
+			arr->LocalHandle(context)->Set(
+				context->LocalHandle(),
+				static_cast<uint32_t>(index),
+				Unwrap(context->Isolate, value)));
+	});
+}
+
+DllPublic void CDecl SetJSArrayPropertyAtIndexDouble(JSContext* context, JSArray* arr, int index, double value, JSScriptException** outError)
+{
+	SetTypedProperty(context, outError, [&] (const v8::TryCatch& tryCatch)
+	{
+		return arr->LocalHandle(context)->Set(context->LocalHandle(), static_cast<uint32_t>(index), v8::Number::New(context->Isolate, value));
+	});
+}
+
+DllPublic void CDecl SetJSArrayPropertyAtIndexInt(JSContext* context, JSArray* arr, int index, int value, JSScriptException** outError)
+{
+	SetTypedProperty(context, outError, [&] (const v8::TryCatch& tryCatch)
+	{
+		return arr->LocalHandle(context)->Set(context->LocalHandle(), static_cast<uint32_t>(index), v8::Integer::New(context->Isolate, value));
+	});
+}
+
+DllPublic void CDecl SetJSArrayPropertyAtIndexBool(JSContext* context, JSArray* arr, int index, bool value, JSScriptException** outError)
+{
+	SetTypedProperty(context, outError, [&] (const v8::TryCatch& tryCatch)
+	{
+		return arr->LocalHandle(context)->Set(context->LocalHandle(), static_cast<uint32_t>(index), v8::Boolean::New(context->Isolate, value));
+	});
+}
+
+DllPublic void CDecl SetJSArrayPropertyAtIndexUtf8(JSContext* context, JSArray* arr, int index, const char* value, int length, JSScriptException** outError)
+{
+	SetTypedProperty(context, outError, [&] (const v8::TryCatch& tryCatch)
+	{
+		return arr->LocalHandle(context)->Set(context->LocalHandle(), static_cast<uint32_t>(index), NewUtf8String(context, tryCatch, value, length));
+	});
+}
+
+DllPublic double CDecl GetJSArrayPropertyAtIndexAsDouble(JSContext* context, JSArray* arr, int index, JSRuntimeError* outError, JSScriptException** outScriptError)
+{
+	return GetTypedProperty<double>(context, outError, outScriptError,
+		[&] { return arr->LocalHandle(context)->Get(context->LocalHandle(), static_cast<uint32_t>(index)); },
+		ToDouble);
+}
+
+DllPublic int CDecl GetJSArrayPropertyAtIndexAsInt(JSContext* context, JSArray* arr, int index, JSRuntimeError* outError, JSScriptException** outScriptError)
+{
+	return GetTypedProperty<int>(context, outError, outScriptError,
+		[&] { return arr->LocalHandle(context)->Get(context->LocalHandle(), static_cast<uint32_t>(index)); },
+		ToInt);
+}
+
+DllPublic bool CDecl GetJSArrayPropertyAtIndexAsBool(JSContext* context, JSArray* arr, int index, JSRuntimeError* outError, JSScriptException** outScriptError)
+{
+	return GetTypedProperty<bool>(context, outError, outScriptError,
+		[&] { return arr->LocalHandle(context)->Get(context->LocalHandle(), static_cast<uint32_t>(index)); },
+		ToBool);
+}
+
+DllPublic int CDecl GetJSArrayPropertyAtIndexAsString(JSContext* context, JSArray* arr, int index, uint16_t* outBuffer, int bufferLength, JSRuntimeError* outError, JSScriptException** outScriptError)
+{
+	return GetTypedProperty<int>(context, outError, outScriptError,
+		[&] { return arr->LocalHandle(context)->Get(context->LocalHandle(), static_cast<uint32_t>(index)); },
+		[&] (v8::Local<v8::Value> value, int& result)
+		{
+			result = WriteStringProperty(value, outBuffer, bufferLength, outError);
+			return true;
+		});
+}
+
+DllPublic int CDecl JSArrayLength(JSContext* context, JSArray* arr, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return 0;
+	}
+	V8Scope scope(context);
+	return static_cast<int>(arr->LocalHandle(context)->Length());
+}
+
+DllPublic JSValue* CDecl JSArrayAsValue(JSArray* arr) { return static_cast<JSValue*>(arr); }
+
+// -------------------------------------------------------------------------
+// Map and Set
+static void ThrowTypeError(JSContext* context, const v8::TryCatch& tryCatch, const char* message)
+{
+	context->Isolate->ThrowException(v8::Exception::TypeError(v8::String::NewFromUtf8(context->Isolate, message)));
+	Throw(context, tryCatch);
+}
+
+static void ThrowRangeError(JSContext* context, const v8::TryCatch& tryCatch, const char* message)
+{
+	context->Isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(context->Isolate, message)));
+	Throw(context, tryCatch);
+}
+
+static v8::Local<v8::Map> AsMap(JSContext* context, const v8::TryCatch& tryCatch, JSObject* map)
+{
+	auto localMap = map->LocalHandle(context);
+	if (!localMap->IsMap())
+		ThrowTypeError(context, tryCatch, "Expected a Map");
+	return localMap.As<v8::Map>();
+}
+
+static v8::Local<v8::Set> AsSet(JSContext* context, const v8::TryCatch& tryCatch, JSObject* set)
+{
+	auto localSet = set->LocalHandle(context);
+	if (!localSet->IsSet())
+		ThrowTypeError(context, tryCatch, "Expected a Set");
+	return localSet.As<v8::Set>();
+}
+
+DllPublic int CDecl JSMapSize(JSContext* context, JSObject* map, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return 0;
+	}
+	V8Scope scope(context);
+	auto localMap = map->LocalHandle(context);
+	return localMap->IsMap() ? static_cast<int>(localMap.As<v8::Map>()->Size()) : 0;
+}
+
+// Releases the values copied so far when a copy fails, so that the caller is
+// left with nothing to release
+static void ReleaseCopiedValues(JSValue** values, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		if (values[i] != nullptr)
+			values[i]->Release();
+		values[i] = nullptr;
+	}
+}
+
+DllPublic int CDecl CopyJSMapEntries(JSContext* context, JSObject* map, JSValue** outKeys, JSValue** outValues, int capacity, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		if (capacity < 0)
+			ThrowRangeError(context, tryCatch, "Negative capacity");
+		auto localContext = context->LocalHandle();
+		auto entries = AsMap(context, tryCatch, map)->AsArray();
+		auto size = static_cast<int>(entries->Length() / 2);
+		auto count = std::min(size, capacity);
+		std::fill(outKeys, outKeys + count, nullptr);
+		std::fill(outValues, outValues + count, nullptr);
+		try
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				v8::HandleScope handleScope(context->Isolate);
+				outKeys[i] = WrapMaybe(context, tryCatch, entries->Get(localContext, static_cast<uint32_t>(2 * i)));
+				outValues[i] = WrapMaybe(context, tryCatch, entries->Get(localContext, static_cast<uint32_t>(2 * i + 1)));
+			}
+		}
+		catch (JSScriptException*)
+		{
+			ReleaseCopiedValues(outKeys, count);
+			ReleaseCopiedValues(outValues, count);
+			throw;
+		}
+		return size;
+	});
+}
+
+DllPublic JSObject* CDecl CreateJSMap(JSContext* context, JSValue* const* keys, JSValue* const* values, int count, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		if (count < 0)
+			ThrowRangeError(context, tryCatch, "Negative count");
+		auto localContext = context->LocalHandle();
+		auto map = v8::Map::New(context->Isolate);
+		for (int i = 0; i < count; ++i)
+		{
+			v8::HandleScope handleScope(context->Isolate);
+			FromJust(context, tryCatch, map->Set(
+				localContext,
+				Unwrap(context->Isolate, keys[i]),
+				Unwrap(context->Isolate, values[i])));
+		}
+		return static_cast<JSObject*>(new JSMap(context->Isolate, map));
+	});
+}
+
+DllPublic int CDecl JSSetSize(JSContext* context, JSObject* set, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return 0;
+	}
+	V8Scope scope(context);
+	auto localSet = set->LocalHandle(context);
+	return localSet->IsSet() ? static_cast<int>(localSet.As<v8::Set>()->Size()) : 0;
+}
+
+DllPublic int CDecl CopyJSSetValues(JSContext* context, JSObject* set, JSValue** outValues, int capacity, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		if (capacity < 0)
+			ThrowRangeError(context, tryCatch, "Negative capacity");
+		auto localContext = context->LocalHandle();
+		auto values = AsSet(context, tryCatch, set)->AsArray();
+		auto size = static_cast<int>(values->Length());
+		auto count = std::min(size, capacity);
+		std::fill(outValues, outValues + count, nullptr);
+		try
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				v8::HandleScope handleScope(context->Isolate);
+				outValues[i] = WrapMaybe(context, tryCatch, values->Get(localContext, static_cast<uint32_t>(i)));
+			}
+		}
+		catch (JSScriptException*)
+		{
+			ReleaseCopiedValues(outValues, count);
+			throw;
+		}
+		return size;
+	});
+}
+
+DllPublic JSObject* CDecl CreateJSSet(JSContext* context, JSValue* const* values, int count, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		if (count < 0)
+			ThrowRangeError(context, tryCatch, "Negative count");
+		auto localContext = context->LocalHandle();
+		auto set = v8::Set::New(context->Isolate);
+		for (int i = 0; i < count; ++i)
+		{
+			v8::HandleScope handleScope(context->Isolate);
+			FromJust(context, tryCatch, set->Add(localContext, Unwrap(context->Isolate, values[i])));
+		}
+		return static_cast<JSObject*>(new JSSet(context->Isolate, set));
+	});
+}
+
+// -------------------------------------------------------------------------
+// Function
+DllPublic JSValue* CDecl CallJSFunctionCreate(JSContext* context, JSFunction* function, JSObject* thisObject, JSValue* const* args, int numArgs, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		std::vector<v8::Local<v8::Value>> unwrappedArgs(numArgs);
+
+		for (int i = 0; i < numArgs; ++i)
+			unwrappedArgs[i] = Unwrap(context->Isolate, args[i]);
+
+		return WrapMaybe(
+			context,
+			tryCatch,
+			function->LocalHandle(context)->Call(
+				context->LocalHandle(),
+				Unwrap(context->Isolate, thisObject),
+				numArgs,
+				data_ptr(unwrappedArgs)));
+
+	});
+}
+
+DllPublic JSObject* CDecl ConstructJSFunctionCreate(JSContext* context, JSFunction* function, JSValue* const* args, int numArgs, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		std::vector<v8::Local<v8::Value>> unwrappedArgs(numArgs);
+
+		for (int i = 0; i < numArgs; ++i)
+			unwrappedArgs[i] = Unwrap(context->Isolate, args[i]);
+
+		return new JSObject(
+			context->Isolate,
+			FromJust(context, tryCatch, function->LocalHandle(context)->NewInstance(
+				context->LocalHandle(),
+				numArgs,
+				data_ptr(unwrappedArgs))));
+	});
+}
+
+DllPublic JSValue* CDecl JSFunctionAsValue(JSFunction* fun) { return static_cast<JSValue*>(fun); }
+
+// -------------------------------------------------------------------------
+// External
+DllPublic JSExternal* CDecl CreateJSExternal(JSContext* context, void* value, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return nullptr;
+	}
+	V8Scope scope(context);
+
+	auto localExternal = v8::External::New(context->Isolate, value);
+
+	struct Closure
+	{
+		ResettingPersistent<v8::External> finalizer;
+		JSExternalFinalizer externalFinalizer;
+		void* value;
+		SnapshotHandle tracked;
+	};
+
+	auto closure = new Closure{{}, context->ExternalFinalizer, value, {context->Isolate}};
+	closure->finalizer.Reset(context->Isolate, localExternal);
+
+	closure->finalizer.SetWeak(
+		closure,
+		[] (const v8::WeakCallbackInfo<Closure>& data)
+		{
+			auto closure = data.GetParameter();
+			if (closure->externalFinalizer != nullptr)
+				closure->externalFinalizer(closure->value);
+			closure->finalizer.Reset();
+			delete closure;
+		},
+		v8::WeakCallbackType::kParameter);
+
+	return new JSExternal(context->Isolate, localExternal);
+}
+
+DllPublic void* CDecl GetJSExternalValue(JSContext* context, JSExternal* external, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return nullptr;
+	}
+	V8Scope scope(context);
+	return external->LocalHandle(context)->Value();
+}
+
+DllPublic JSValue* CDecl JSExternalAsValue(JSExternal* external) { return static_cast<JSValue*>(external); }
+
+// -------------------------------------------------------------------------
+// Entries
+struct JSEntries
+{
+	std::vector<char> Keys;
+	std::vector<int> KeyEnds;
+	std::vector<JSValue*> Values;
+
+	~JSEntries()
+	{
+		for (auto value : Values)
+		{
+			if (value != nullptr)
+				value->Release();
+		}
+	}
+};
+
+struct JSEntriesCursor
+{
+	SnapshotHandle Tracked;
+	ResettingPersistent<v8::Object> Object;
+	ResettingPersistent<v8::Array> Keys;
+	uint32_t Position;
+
+	JSEntriesCursor(JSContext* context) : Tracked(context->Isolate), Position(0) { }
+};
+
+static JSEntries* CopyEntries(
+	JSContext* context,
+	const v8::TryCatch& tryCatch,
+	v8::Local<v8::Object> obj,
+	v8::Local<v8::Array> keys,
+	uint32_t& position,
+	uint32_t end,
+	bool utf8,
+	bool skipDeleted)
+{
+	auto localContext = context->LocalHandle();
+	std::unique_ptr<JSEntries> entries(new JSEntries());
+	entries->KeyEnds.reserve(end - position);
+	entries->Values.reserve(end - position);
+	auto unitSize = utf8 ? 1 : sizeof(uint16_t);
+	int keysLength = 0;
+	for (; position < end; ++position)
+	{
+		v8::HandleScope handleScope(context->Isolate);
+		auto key = FromJust(context, tryCatch, keys->Get(localContext, position));
+		auto keyString = FromJust(context, tryCatch, key->ToString(localContext));
+		if (skipDeleted && !FromJust(context, tryCatch, obj->HasOwnProperty(localContext, keyString)))
+			continue;
+		auto value = FromJust(context, tryCatch, obj->Get(localContext, keyString));
+
+		auto length = utf8 ? keyString->Utf8Length() : keyString->Length();
+		entries->Keys.resize((keysLength + length) * unitSize);
+		if (utf8)
+		{
+			keyString->WriteUtf8(
+				data_ptr(entries->Keys) + keysLength,
+				length,
+				nullptr,
+				v8::String::NO_NULL_TERMINATION | v8::String::REPLACE_INVALID_UTF8);
+		}
+		else
+		{
+			keyString->Write(
+				reinterpret_cast<uint16_t*>(data_ptr(entries->Keys)) + keysLength,
+				0,
+				length,
+				v8::String::NO_NULL_TERMINATION);
+		}
+		keysLength += length;
+		entries->KeyEnds.push_back(keysLength);
+		entries->Values.push_back(Wrap(context, tryCatch, value));
+	}
+	return entries.release();
+}
+
+DllPublic JSEntries* CDecl CopyJSObjectEntries(JSContext* context, JSObject* obj, bool utf8, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		auto localObj = obj->LocalHandle(context);
+		auto keys = FromJust(context, tryCatch, localObj->GetOwnPropertyNames(context->LocalHandle()));
+		uint32_t position = 0;
+		return CopyEntries(context, tryCatch, localObj, keys, position, keys->Length(), utf8, false);
+	});
+}
+
+DllPublic void CDecl ReleaseJSEntries(JSContext* context, JSEntries* entries)
+{
+	if (entries != nullptr && context != nullptr)
+		ReleaseOnOwnerThread(context, [entries] { delete entries; });
+}
+
+DllPublic int CDecl JSEntriesCount(JSEntries* entries) { return static_cast<int>(entries->Values.size()); }
+
+DllPublic int CDecl JSEntriesKeysLength(JSEntries* entries)
+{
+	return entries->KeyEnds.empty() ? 0 : entries->KeyEnds.back();
+}
+
+DllPublic void CDecl WriteJSEntriesKeys(JSEntries* entries, void* outKeys, int* outKeyEnds)
+{
+	std::copy(entries->Keys.begin(), entries->Keys.end(), static_cast<char*>(outKeys));
+	std::copy(entries->KeyEnds.begin(), entries->KeyEnds.end(), outKeyEnds);
+}
+
+DllPublic void CDecl CopyJSEntriesValues(JSEntries* entries, JSValue** outValues)
+{
+	for (auto value : entries->Values)
+	{
+		if (value != nullptr)
+			value->Retain();
+		*outValues++ = value;
+	}
+}
+
+DllPublic JSEntriesCursor* CDecl CreateJSEntriesCursor(JSContext* context, JSObject* obj, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		auto localObj = obj->LocalHandle(context);
+		auto cursor = new JSEntriesCursor(context);
+		cursor->Object.Reset(context->Isolate, localObj);
+		cursor->Keys.Reset(context->Isolate, FromJust(context, tryCatch, localObj->GetOwnPropertyNames(context->LocalHandle())));
+		cursor->Position = 0;
+		return cursor;
+	});
+}
+
+DllPublic void CDecl ReleaseJSEntriesCursor(JSContext* context, JSEntriesCursor* cursor)
+{
+	if (cursor != nullptr && context != nullptr)
+		ReleaseOnOwnerThread(context, [cursor] { delete cursor; });
+}
+
+DllPublic JSEntries* CDecl CopyNextJSEntries(JSContext* context, JSEntriesCursor* cursor, int maxCount, bool utf8, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch) -> JSEntries*
+	{
+		auto keys = cursor->Keys.Get(context->Isolate);
+		auto length = keys->Length();
+		if (cursor->Position >= length)
+			return nullptr;
+		auto end = cursor->Position + std::min(length - cursor->Position, static_cast<uint32_t>(std::max(maxCount, 1)));
+		return CopyEntries(context, tryCatch, cursor->Object.Get(context->Isolate), keys, cursor->Position, end, utf8, true);
+	});
+}
+
+// -------------------------------------------------------------------------
+// Array cursor
+struct JSArrayCursor
+{
+	// Taken before anything else, so that it is the outermost lock
+	IsolateLock Lock;
+	const std::thread::id Thread;
+	SnapshotHandle Tracked;
+	ResettingPersistent<v8::Array> Array;
+	uint32_t Position;
+
+	JSArrayCursor(JSContext* context, JSArray* arr)
+		: Lock(context)
+		, Thread(std::this_thread::get_id())
+		, Tracked(context->Isolate)
+		, Array(context->Isolate, arr->Handle)
+		, Position(0)
+	{
+	}
+};
+
+DllPublic JSArrayCursor* CDecl CreateJSArrayCursor(JSContext* context, JSArray* arr, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return nullptr;
+	}
+	return new JSArrayCursor(context, arr);
+}
+
+DllPublic void CDecl ReleaseJSArrayCursor(JSContext* context, JSArrayCursor* cursor, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (cursor == nullptr || cursor->Thread == std::this_thread::get_id())
+		delete cursor;
+	// A single-owner cursor holds no lock, so only its handle needs the owner,
+	// which is the thread that created it. The lock of any other cursor has to
+	// be released by the thread that took it.
+	else if (context->SingleOwner)
+		ReleaseOnOwnerThread(context, [cursor] { delete cursor; });
+	else
+		*outError = JSRuntimeError::WrongThread;
+}
+
+DllPublic int CDecl CopyNextJSArrayElements(JSContext* context, JSArrayCursor* cursor, JSType* outTypes, double* outNumbers, JSValue** outValues, int maxCount, JSScriptException** outError)
+{
+	if (!IsOwnerThread(context) || cursor->Thread != std::this_thread::get_id())
+	{
+		*outError = WrongThreadException(context);
+		return 0;
+	}
+	// The cursor holds the lock, so there is no need to take it again
+	CpuTimer timer(context, context->CpuScopeDepth, context->CpuNanos);
+	EnteredScope scope(context);
+	return TryCatch(outError, scope, [&] (v8::TryCatch& tryCatch)
+	{
+		auto localContext = context->LocalHandle();
+		auto arr = cursor->Array.Get(context->Isolate);
+		auto length = arr->Length();
+		int count = 0;
+		for (; count < maxCount && cursor->Position < length; ++count, ++cursor->Position)
+		{
+			v8::HandleScope handleScope(context->Isolate);
+			auto value = FromJust(context, tryCatch, arr->Get(localContext, cursor->Position));
+			outNumbers[count] = 0.0;
+			outValues[count] = nullptr;
+			if (value->IsInt32())
+			{
+				outTypes[count] = JSType::Int;
+				outNumbers[count] = value.As<v8::Int32>()->Value();
+			}
+			else if (value->IsNumber())
+			{
+				outTypes[count] = JSType::Double;
+				outNumbers[count] = value.As<v8::Number>()->Value();
+			}
+			else if (value->IsBoolean())
+			{
+				outTypes[count] = JSType::Bool;
+				outNumbers[count] = value->IsTrue() ? 1.0 : 0.0;
+			}
+			else
+			{
+				outValues[count] = Wrap(context, tryCatch, value);
+				outTypes[count] = GetJSValueType(outValues[count]);
+			}
+		}
+		return count;
+	});
+}
+
+// -------------------------------------------------------------------------
+// Property accessors
+// V8 doesn't expose hidden classes through its API, so there is no way to
+// cache the lookup itself here; the key is what we can keep.
+struct JSPropertyAccessor
+{
+	SnapshotHandle Tracked;
+	ResettingPersistent<v8::String> Key;
+
+	JSPropertyAccessor(JSContext* context) : Tracked(context->Isolate) { }
+
+	inline v8::MaybeLocal<v8::Value> Get(JSContext* context, JSObject* obj)
+	{
+		return obj->LocalHandle(context)->Get(context->LocalHandle(), Key.Get(context->Isolate));
+	}
+
+	inline v8::Maybe<bool> Set(JSContext* context, JSObject* obj, v8::Local<v8::Value> value)
+	{
+		return obj->LocalHandle(context)->Set(context->LocalHandle(), Key.Get(context->Isolate), value);
+	}
+};
+
+DllPublic JSPropertyAccessor* CDecl CreateJSPropertyAccessor(JSContext* context, const uint16_t* name, int length, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return nullptr;
+	}
+	V8Scope scope(context);
+	auto key = v8::String::NewFromTwoByte(
+		context->Isolate,
+		name,
+		v8::NewStringType::kInternalized,
+		length);
+	if (key.IsEmpty())
+	{
+		*outError = JSRuntimeError::StringTooLong;
+		return nullptr;
+	}
+	auto accessor = new JSPropertyAccessor(context);
+	accessor->Key.Reset(context->Isolate, key.ToLocalChecked());
+	return accessor;
+}
+
+DllPublic void CDecl ReleaseJSPropertyAccessor(JSContext* context, JSPropertyAccessor* accessor)
+{
+	if (accessor != nullptr && context != nullptr)
+		ReleaseOnOwnerThread(context, [accessor] { delete accessor; });
+}
+
+DllPublic JSValue* CDecl CopyJSPropertyAccessorValue(JSContext* context, JSPropertyAccessor* accessor, JSObject* obj, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return WrapMaybe(context, tryCatch, accessor->Get(context, obj));
+	});
+}
+
+DllPublic void CDecl SetJSPropertyAccessorValue(JSContext* context, JSPropertyAccessor* accessor, JSObject* obj, JSValue* value, JSScriptException** outError)
+{
+	SetTypedProperty(context, outError, [&] (const v8::TryCatch&)
+	{
+		return accessor->Set(context, obj, Unwrap(context->Isolate, value));
+	});
+}
+
+DllPublic double CDecl GetJSPropertyAccessorAsDouble(JSContext* context, JSPropertyAccessor* accessor, JSObject* obj, JSRuntimeError* outError, JSScriptException** outScriptError)
+{
+	return GetTypedProperty<double>(context, outError, outScriptError, [&] { return accessor->Get(context, obj); }, ToDouble);
+}
+
+DllPublic int CDecl GetJSPropertyAccessorAsInt(JSContext* context, JSPropertyAccessor* accessor, JSObject* obj, JSRuntimeError* outError, JSScriptException** outScriptError)
+{
+	return GetTypedProperty<int>(context, outError, outScriptError, [&] { return accessor->Get(context, obj); }, ToInt);
+}
+
+DllPublic bool CDecl GetJSPropertyAccessorAsBool(JSContext* context, JSPropertyAccessor* accessor, JSObject* obj, JSRuntimeError* outError, JSScriptException** outScriptError)
+{
+	return GetTypedProperty<bool>(context, outError, outScriptError, [&] { return accessor->Get(context, obj); }, ToBool);
+}
+
+DllPublic void CDecl SetJSPropertyAccessorDouble(JSContext* context, JSPropertyAccessor* accessor, JSObject* obj, double value, JSScriptException** outError)
+{
+	SetTypedProperty(context, outError, [&] (const v8::TryCatch&)
+	{
+		return accessor->Set(context, obj, v8::Number::New(context->Isolate, value));
+	});
+}
+
+DllPublic void CDecl SetJSPropertyAccessorInt(JSContext* context, JSPropertyAccessor* accessor, JSObject* obj, int value, JSScriptException** outError)
+{
+	SetTypedProperty(context, outError, [&] (const v8::TryCatch&)
+	{
+		return accessor->Set(context, obj, v8::Integer::New(context->Isolate, value));
+	});
+}
+
+DllPublic void CDecl SetJSPropertyAccessorBool(JSContext* context, JSPropertyAccessor* accessor, JSObject* obj, bool value, JSScriptException** outError)
+{
+	SetTypedProperty(context, outError, [&] (const v8::TryCatch&)
+	{
+		return accessor->Set(context, obj, v8::Boolean::New(context->Isolate, value));
+	});
+}
+
+// -------------------------------------------------------------------------
+// JSON
+// v8::JSON::Stringify only takes objects, so other values are stringified
+// wrapped in an array and the surrounding brackets are skipped when copying
+// out the result.
+// Returns an empty handle for values that have no JSON text, i.e. where
+// JSON.stringify returns undefined (functions, and objects whose toJSON
+// returns undefined or a function). Host values are never undefined.
+static v8::Local<v8::String> Stringify(JSContext* context, const v8::TryCatch& tryCatch, JSValue* value, bool& outBracketed)
+{
+	auto localContext = context->LocalHandle();
+	auto unwrapped = Unwrap(context->Isolate, value);
+	outBracketed = !unwrapped->IsObject();
+	if (outBracketed)
+	{
+		auto array = v8::Array::New(context->Isolate, 1);
+		FromJust(context, tryCatch, array->Set(localContext, 0, unwrapped));
+		unwrapped = array;
+	}
+	auto result = FromJust(context, tryCatch, v8::JSON::Stringify(localContext, unwrapped.As<v8::Object>()));
+	// V8 converts an undefined result to a string, which can't be valid JSON
+	if (!outBracketed && result->StrictEquals(v8::String::NewFromUtf8(context->Isolate, "undefined")))
+		return v8::Local<v8::String>();
+	return result;
+}
+
+DllPublic JSValue* CDecl JSONParseUtf16Create(JSContext* context, const uint16_t* json, int length, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		auto string = FromJust(context, tryCatch, v8::String::NewFromTwoByte(context->Isolate, json, v8::NewStringType::kNormal, length));
+		return WrapMaybe(context, tryCatch, v8::JSON::Parse(context->LocalHandle(), string));
+	});
+}
+
+DllPublic JSValue* CDecl JSONParseUtf8Create(JSContext* context, const char* json, int length, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		auto string = FromJust(context, tryCatch, v8::String::NewFromUtf8(context->Isolate, json, v8::NewStringType::kNormal, length));
+		return WrapMaybe(context, tryCatch, v8::JSON::Parse(context->LocalHandle(), string));
+	});
+}
+
+DllPublic int CDecl JSONStringifyUtf16(JSContext* context, JSValue* value, uint16_t* outBuffer, int bufferLength, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		bool bracketed;
+		auto string = Stringify(context, tryCatch, value, bracketed);
+		if (string.IsEmpty())
+			return -1;
+		auto start = bracketed ? 1 : 0;
+		auto length = string->Length() - 2 * start;
+		if (length <= bufferLength)
+			string->Write(outBuffer, start, length, v8::String::NO_NULL_TERMINATION);
+		return length;
+	});
+}
+
+DllPublic int CDecl JSONStringifyUtf8(JSContext* context, JSValue* value, char* outBuffer, int bufferLength, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		bool bracketed;
+		auto string = Stringify(context, tryCatch, value, bracketed);
+		if (string.IsEmpty())
+			return -1;
+		if (bracketed)
+		{
+			// Only primitives take this path, so the copy is small
+			std::vector<char> utf8(string->Utf8Length());
+			string->WriteUtf8(data_ptr(utf8), static_cast<int>(utf8.size()), nullptr, v8::String::NO_NULL_TERMINATION);
+			auto length = static_cast<int>(utf8.size()) - 2;
+			if (length <= bufferLength)
+				std::copy(utf8.begin() + 1, utf8.end() - 1, outBuffer);
+			return length;
+		}
+		auto length = string->Utf8Length();
+		if (length <= bufferLength)
+			string->WriteUtf8(outBuffer, length, nullptr, v8::String::NO_NULL_TERMINATION);
+		return length;
+	});
+}
+
+// -------------------------------------------------------------------------
+// Binary encoding
+// Values are encoded as MessagePack (https://msgpack.org). Errors are thrown
+// as JavaScript exceptions so that they are reported like those from
+// property getters that run during encoding.
+struct BinaryEncoder
+{
+	JSContext* const Context;
+	const v8::TryCatch& TryCatch;
+	const v8::Local<v8::Context> LocalContext;
+	uint8_t* const Buffer;
+	const size_t Capacity;
+	const int MaxDepth;
+	size_t Length;
+	std::vector<v8::Local<v8::Object>> Path;
+
+	BinaryEncoder(JSContext* context, const v8::TryCatch& tryCatch, void* buffer, int capacity, int maxDepth)
+		: Context(context)
+		, TryCatch(tryCatch)
+		, LocalContext(context->LocalHandle())
+		, Buffer(static_cast<uint8_t*>(buffer))
+		, Capacity(capacity < 0 ? 0 : static_cast<size_t>(capacity))
+		, MaxDepth(maxDepth)
+		, Length(0)
+	{
+	}
+
+	void Fail(v8::Local<v8::Value> (*error)(v8::Local<v8::String>), const char* message)
+	{
+		Context->Isolate->ThrowException(error(v8::String::NewFromUtf8(Context->Isolate, message)));
+		Throw(Context, TryCatch);
+	}
+
+	uint8_t* Reserve(size_t length)
+	{
+		if (Capacity - Length < length)
+			Fail(v8::Exception::RangeError, "Encoded value does not fit in the buffer");
+		auto result = Buffer + Length;
+		Length += length;
+		return result;
+	}
+
+	void WriteByte(uint8_t value) { *Reserve(1) = value; }
+
+	template<typename T>
+	void WriteBigEndian(uint8_t type, T value)
+	{
+		auto p = Reserve(1 + sizeof(T));
+		*p++ = type;
+		for (int shift = 8 * (sizeof(T) - 1); shift >= 0; shift -= 8)
+			*p++ = static_cast<uint8_t>(static_cast<uint64_t>(value) >> shift);
+	}
+
+	// Writes the smallest of the fix, 8-, 16- and 32-bit forms of a header.
+	// Pass 0 for the forms the type doesn't have.
+	void WriteHeader(uint32_t length, uint8_t fixType, uint32_t fixLimit, uint8_t type8, uint8_t type16, uint8_t type32)
+	{
+		if (length < fixLimit)
+			WriteByte(static_cast<uint8_t>(fixType | length));
+		else if (type8 != 0 && length <= 0xff)
+			WriteBigEndian(type8, static_cast<uint8_t>(length));
+		else if (length <= 0xffff)
+			WriteBigEndian(type16, static_cast<uint16_t>(length));
+		else
+			WriteBigEndian(type32, length);
+	}
+
+	void WriteInt(int32_t value)
+	{
+		if (value >= -32 && value <= 127)
+			WriteByte(static_cast<uint8_t>(value));
+		else if (value >= 0 && value <= UINT8_MAX)
+			WriteBigEndian(0xcc, static_cast<uint8_t>(value));
+		else if (value >= 0 && value <= UINT16_MAX)
+			WriteBigEndian(0xcd, static_cast<uint16_t>(value));
+		else if (value >= INT8_MIN && value <= INT8_MAX)
+			WriteBigEndian(0xd0, static_cast<int8_t>(value));
+		else if (value >= INT16_MIN && value <= INT16_MAX)
+			WriteBigEndian(0xd1, static_cast<int16_t>(value));
+		else
+			WriteBigEndian(0xd2, value);
+	}
+
+	void WriteDouble(double value)
+	{
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		WriteBigEndian(0xcb, bits);
+	}
+
+	void WriteString(v8::Local<v8::String> value)
+	{
+		auto length = value->Utf8Length();
+		WriteHeader(static_cast<uint32_t>(length), 0xa0, 32, 0xd9, 0xda, 0xdb);
+		value->WriteUtf8(
+			reinterpret_cast<char*>(Reserve(length)),
+			length,
+			nullptr,
+			v8::String::NO_NULL_TERMINATION | v8::String::REPLACE_INVALID_UTF8);
+	}
+
+	void WriteBinary(const uint8_t* data, size_t length)
+	{
+		WriteHeader(static_cast<uint32_t>(length), 0, 0, 0xc4, 0xc5, 0xc6);
+		memcpy(Reserve(length), data, length);
+	}
+
+	// Timestamp extension type (-1) in its 96-bit form
+	void WriteDate(double milliseconds)
+	{
+		if (milliseconds != milliseconds)
+		{
+			WriteByte(0xc0);
+			return;
+		}
+		auto seconds = static_cast<int64_t>(std::floor(milliseconds / 1000));
+		auto nanoseconds = static_cast<uint32_t>((milliseconds - seconds * 1000.0) * 1000000);
+		WriteBigEndian(0xc7, static_cast<uint8_t>(12));
+		WriteByte(0xff);
+		auto p = Reserve(12);
+		for (int shift = 24; shift >= 0; shift -= 8)
+			*p++ = static_cast<uint8_t>(nanoseconds >> shift);
+		for (int shift = 56; shift >= 0; shift -= 8)
+			*p++ = static_cast<uint8_t>(static_cast<uint64_t>(seconds) >> shift);
+	}
+
+	void Enter(v8::Local<v8::Object> object)
+	{
+		if (static_cast<int>(Path.size()) >= MaxDepth)
+			Fail(v8::Exception::RangeError, "Value is nested too deeply to encode");
+		for (auto& parent : Path)
+		{
+			if (parent->StrictEquals(object))
+				Fail(v8::Exception::TypeError, "Cannot encode circular structure");
+		}
+		Path.push_back(object);
+	}
+
+	void Leave() { Path.pop_back(); }
+
+	void WriteArray(v8::Local<v8::Array> array)
+	{
+		auto length = array->Length();
+		WriteHeader(length, 0x90, 16, 0, 0xdc, 0xdd);
+		for (uint32_t i = 0; i < length; ++i)
+		{
+			v8::HandleScope handleScope(Context->Isolate);
+			Encode(FromJust(Context, TryCatch, array->Get(LocalContext, i)));
+		}
+	}
+
+	void WriteObject(v8::Local<v8::Object> object)
+	{
+		auto keys = FromJust(Context, TryCatch, object->GetOwnPropertyNames(LocalContext));
+		auto length = keys->Length();
+		WriteHeader(length, 0x80, 16, 0, 0xde, 0xdf);
+		for (uint32_t i = 0; i < length; ++i)
+		{
+			v8::HandleScope handleScope(Context->Isolate);
+			auto key = FromJust(Context, TryCatch, keys->Get(LocalContext, i));
+			auto keyString = key->IsString()
+				? key.As<v8::String>()
+				: FromJust(Context, TryCatch, key->ToString(LocalContext));
+			WriteString(keyString);
+			Encode(FromJust(Context, TryCatch, object->Get(LocalContext, key)));
+		}
+	}
+
+	void Encode(v8::Local<v8::Value> value)
+	{
+		if (value->IsUndefined() || value->IsNull())
+			WriteByte(0xc0);
+		else if (value->IsBoolean())
+			WriteByte(value->IsTrue() ? 0xc3 : 0xc2);
+		else if (value->IsInt32())
+			WriteInt(value.As<v8::Int32>()->Value());
+		else if (value->IsNumber())
+			WriteDouble(value.As<v8::Number>()->Value());
+		else if (value->IsString())
+			WriteString(value.As<v8::String>());
+		else if (value->IsArrayBuffer())
+		{
+			auto contents = value.As<v8::ArrayBuffer>()->GetContents();
+			WriteBinary(static_cast<const uint8_t*>(contents.Data()), contents.ByteLength());
+		}
+		else if (value->IsArrayBufferView())
+		{
+			auto view = value.As<v8::ArrayBufferView>();
+			auto contents = view->Buffer()->GetContents();
+			WriteBinary(static_cast<const uint8_t*>(contents.Data()) + view->ByteOffset(), view->ByteLength());
+		}
+		else if (value->IsDate())
+			WriteDate(value.As<v8::Date>()->ValueOf());
+		else if (value->IsFunction() || value->IsSymbol() || value->IsExternal())
+			Fail(v8::Exception::TypeError, "Cannot encode functions, symbols or externals");
+		else if (value->IsObject())
+		{
+			auto object = value.As<v8::Object>();
+			Enter(object);
+			if (value->IsArray())
+				WriteArray(value.As<v8::Array>());
+			else if (value->IsSet())
+				WriteArray(value.As<v8::Set>()->AsArray());
+			else if (value->IsMap())
+			{
+				auto entries = value.As<v8::Map>()->AsArray();
+				auto length = entries->Length();
+				WriteHeader(length / 2, 0x80, 16, 0, 0xde, 0xdf);
+				for (uint32_t i = 0; i < length; ++i)
+				{
+					v8::HandleScope handleScope(Context->Isolate);
+					Encode(FromJust(Context, TryCatch, entries->Get(LocalContext, i)));
+				}
+			}
+			else
+				WriteObject(object);
+			Leave();
+		}
+		else
+			Fail(v8::Exception::TypeError, "Cannot encode value");
+	}
+};
+
+struct BinaryDecoder
+{
+	JSContext* const Context;
+	v8::Isolate* const Isolate;
+	const v8::TryCatch& TryCatch;
+	const v8::Local<v8::Context> LocalContext;
+	const uint8_t* Position;
+	const uint8_t* const End;
+	const int MaxDepth;
+	int Depth;
+
+	// Map keys tend to repeat, so they are looked up by their bytes in the
+	// input before creating (internalized) strings.
+	struct Key
+	{
+		const uint8_t* Data;
+		uint32_t Length;
+		uint32_t Hash;
+		v8::Local<v8::String> String;
+	};
+	std::vector<Key> Keys;
+	size_t KeyCount;
+
+	BinaryDecoder(JSContext* context, const v8::TryCatch& tryCatch, const void* data, int length, int maxDepth)
+		: Context(context)
+		, Isolate(context->Isolate)
+		, TryCatch(tryCatch)
+		, LocalContext(context->LocalHandle())
+		, Position(static_cast<const uint8_t*>(data))
+		, End(static_cast<const uint8_t*>(data) + (length < 0 ? 0 : length))
+		, MaxDepth(maxDepth)
+		, Depth(0)
+		, Keys(64)
+		, KeyCount(0)
+	{
+	}
+
+	void Fail(v8::Local<v8::Value> (*error)(v8::Local<v8::String>), const char* message)
+	{
+		Isolate->ThrowException(error(v8::String::NewFromUtf8(Isolate, message)));
+		Throw(Context, TryCatch);
+	}
+
+	const uint8_t* Read(size_t length)
+	{
+		if (static_cast<size_t>(End - Position) < length)
+			Fail(v8::Exception::RangeError, "Unexpected end of encoded data");
+		auto result = Position;
+		Position += length;
+		return result;
+	}
+
+	// Every element takes at least one byte, so a count larger than what is
+	// left is corrupt, and must be rejected before anything is sized from it
+	void CheckCount(uint32_t count, size_t bytesPerElement)
+	{
+		if (static_cast<size_t>(End - Position) / bytesPerElement < count)
+			Fail(v8::Exception::RangeError, "Unexpected end of encoded data");
+	}
+
+	template<typename T>
+	T ReadBigEndian()
+	{
+		auto p = Read(sizeof(T));
+		uint64_t value = 0;
+		for (size_t i = 0; i < sizeof(T); ++i)
+			value = (value << 8) | p[i];
+		return static_cast<T>(value);
+	}
+
+	double ReadDouble()
+	{
+		auto bits = ReadBigEndian<uint64_t>();
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	float ReadFloat()
+	{
+		auto bits = ReadBigEndian<uint32_t>();
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	v8::Local<v8::String> ReadString(uint32_t length)
+	{
+		auto data = Read(length);
+		return FromJust(Context, TryCatch, v8::String::NewFromUtf8(
+			Isolate,
+			reinterpret_cast<const char*>(data),
+			v8::NewStringType::kNormal,
+			static_cast<int>(length)));
+	}
+
+	v8::Local<v8::String> ReadKey(uint32_t length)
+	{
+		auto data = Read(length);
+		uint32_t hash = 2166136261u;
+		for (uint32_t i = 0; i < length; ++i)
+			hash = (hash ^ data[i]) * 16777619u;
+
+		auto mask = Keys.size() - 1;
+		auto index = hash & mask;
+		for (; Keys[index].Data != nullptr; index = (index + 1) & mask)
+		{
+			auto& key = Keys[index];
+			if (key.Hash == hash && key.Length == length && memcmp(key.Data, data, length) == 0)
+				return key.String;
+		}
+
+		auto string = FromJust(Context, TryCatch, v8::String::NewFromUtf8(
+			Isolate,
+			reinterpret_cast<const char*>(data),
+			v8::NewStringType::kInternalized,
+			static_cast<int>(length)));
+		Keys[index] = Key{data, length, hash, string};
+		if (++KeyCount * 2 > Keys.size())
+			GrowKeys();
+		return string;
+	}
+
+	void GrowKeys()
+	{
+		std::vector<Key> old(Keys.size() * 2);
+		old.swap(Keys);
+		auto mask = Keys.size() - 1;
+		for (auto& key : old)
+		{
+			if (key.Data == nullptr)
+				continue;
+			auto index = key.Hash & mask;
+			while (Keys[index].Data != nullptr)
+				index = (index + 1) & mask;
+			Keys[index] = key;
+		}
+	}
+
+	v8::Local<v8::Value> ReadBinary(uint32_t length)
+	{
+		auto data = Read(length);
+		auto arrayBuffer = v8::ArrayBuffer::New(Isolate, length);
+		memcpy(arrayBuffer->GetContents().Data(), data, length);
+		return arrayBuffer;
+	}
+
+	v8::Local<v8::Value> ReadExtension(uint32_t length)
+	{
+		auto type = static_cast<int8_t>(*Read(1));
+		if (type != -1)
+			Fail(v8::Exception::TypeError, "Unsupported MessagePack extension type");
+
+		int64_t seconds;
+		uint32_t nanoseconds;
+		switch (length)
+		{
+			case 4:
+				nanoseconds = 0;
+				seconds = ReadBigEndian<uint32_t>();
+				break;
+			case 8:
+			{
+				auto bits = ReadBigEndian<uint64_t>();
+				nanoseconds = static_cast<uint32_t>(bits >> 34);
+				seconds = static_cast<int64_t>(bits & 0x3ffffffffull);
+				break;
+			}
+			case 12:
+				nanoseconds = ReadBigEndian<uint32_t>();
+				seconds = ReadBigEndian<int64_t>();
+				break;
+			default:
+				Fail(v8::Exception::TypeError, "Invalid MessagePack timestamp");
+				return v8::Local<v8::Value>();
+		}
+		return FromJust(Context, TryCatch, v8::Date::New(LocalContext, seconds * 1000.0 + nanoseconds / 1000000.0));
+	}
+
+	v8::Local<v8::Value> ReadArray(uint32_t length)
+	{
+		CheckCount(length, 1);
+		Enter();
+		auto array = v8::Array::New(Isolate, static_cast<int>(length));
+		for (uint32_t i = 0; i < length; ++i)
+			FromJust(Context, TryCatch, array->CreateDataProperty(LocalContext, i, Decode()));
+		Leave();
+		return array;
+	}
+
+	v8::Local<v8::Value> ReadMap(uint32_t length)
+	{
+		CheckCount(length, 2);
+		Enter();
+		auto object = v8::Object::New(Isolate);
+		for (uint32_t i = 0; i < length; ++i)
+		{
+			auto type = *Read(1);
+			if ((type & 0xe0) == 0xa0)
+				FromJust(Context, TryCatch, object->CreateDataProperty(LocalContext, ReadKey(type & 0x1f), Decode()));
+			else if (type == 0xd9)
+				FromJust(Context, TryCatch, object->CreateDataProperty(LocalContext, ReadKey(ReadBigEndian<uint8_t>()), Decode()));
+			else if (type == 0xda)
+				FromJust(Context, TryCatch, object->CreateDataProperty(LocalContext, ReadKey(ReadBigEndian<uint16_t>()), Decode()));
+			else if (type == 0xdb)
+				FromJust(Context, TryCatch, object->CreateDataProperty(LocalContext, ReadKey(ReadBigEndian<uint32_t>()), Decode()));
+			else
+			{
+				// Integer keys become indexed properties, as they would in JSON
+				--Position;
+				auto key = Decode();
+				if (!key->IsUint32())
+					Fail(v8::Exception::TypeError, "Map keys must be strings or non-negative integers");
+				FromJust(Context, TryCatch, object->CreateDataProperty(LocalContext, key.As<v8::Uint32>()->Value(), Decode()));
+			}
+		}
+		Leave();
+		return object;
+	}
+
+	void Enter()
+	{
+		if (++Depth > MaxDepth)
+			Fail(v8::Exception::RangeError, "Encoded value is nested too deeply");
+	}
+
+	void Leave() { --Depth; }
+
+	v8::Local<v8::Value> Decode()
+	{
+		auto type = *Read(1);
+		if (type <= 0x7f)
+			return v8::Integer::New(Isolate, type);
+		if (type >= 0xe0)
+			return v8::Integer::New(Isolate, static_cast<int8_t>(type));
+		if ((type & 0xf0) == 0x80)
+			return ReadMap(type & 0x0f);
+		if ((type & 0xf0) == 0x90)
+			return ReadArray(type & 0x0f);
+		if ((type & 0xe0) == 0xa0)
+			return ReadString(type & 0x1f);
+
+		switch (type)
+		{
+			case 0xc0: return v8::Null(Isolate);
+			case 0xc2: return v8::False(Isolate);
+			case 0xc3: return v8::True(Isolate);
+			case 0xc4: return ReadBinary(ReadBigEndian<uint8_t>());
+			case 0xc5: return ReadBinary(ReadBigEndian<uint16_t>());
+			case 0xc6: return ReadBinary(ReadBigEndian<uint32_t>());
+			case 0xc7: return ReadExtension(ReadBigEndian<uint8_t>());
+			case 0xc8: return ReadExtension(ReadBigEndian<uint16_t>());
+			case 0xc9: return ReadExtension(ReadBigEndian<uint32_t>());
+			case 0xca: return v8::Number::New(Isolate, ReadFloat());
+			case 0xcb: return v8::Number::New(Isolate, ReadDouble());
+			case 0xcc: return v8::Integer::New(Isolate, ReadBigEndian<uint8_t>());
+			case 0xcd: return v8::Integer::New(Isolate, ReadBigEndian<uint16_t>());
+			case 0xce: return v8::Integer::NewFromUnsigned(Isolate, ReadBigEndian<uint32_t>());
+			case 0xcf: return v8::Number::New(Isolate, static_cast<double>(ReadBigEndian<uint64_t>()));
+			case 0xd0: return v8::Integer::New(Isolate, ReadBigEndian<int8_t>());
+			case 0xd1: return v8::Integer::New(Isolate, ReadBigEndian<int16_t>());
+			case 0xd2: return v8::Integer::New(Isolate, ReadBigEndian<int32_t>());
+			case 0xd3: return v8::Number::New(Isolate, static_cast<double>(ReadBigEndian<int64_t>()));
+			case 0xd4: return ReadExtension(1);
+			case 0xd5: return ReadExtension(2);
+			case 0xd6: return ReadExtension(4);
+			case 0xd7: return ReadExtension(8);
+			case 0xd8: return ReadExtension(16);
+			case 0xd9: return ReadString(ReadBigEndian<uint8_t>());
+			case 0xda: return ReadString(ReadBigEndian<uint16_t>());
+			case 0xdb: return ReadString(ReadBigEndian<uint32_t>());
+			case 0xdc: return ReadArray(ReadBigEndian<uint16_t>());
+			case 0xdd: return ReadArray(ReadBigEndian<uint32_t>());
+			case 0xde: return ReadMap(ReadBigEndian<uint16_t>());
+			case 0xdf: return ReadMap(ReadBigEndian<uint32_t>());
+			default: break;
+		}
+		Fail(v8::Exception::TypeError, "Invalid MessagePack type");
+		return v8::Local<v8::Value>();
+	}
+};
+
+DllPublic int CDecl EncodeJSValue(JSContext* context, JSValue* value, void* outBuffer, int bufferLength, int maxDepth, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		BinaryEncoder encoder(context, tryCatch, outBuffer, bufferLength, maxDepth);
+		encoder.Encode(Unwrap(context->Isolate, value));
+		return static_cast<int>(encoder.Length);
+	});
+}
+
+DllPublic JSValue* CDecl DecodeJSValueCreate(JSContext* context, const void* data, int length, int maxDepth, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		BinaryDecoder decoder(context, tryCatch, data, length, maxDepth);
+		auto value = decoder.Decode();
+		if (decoder.Position != decoder.End)
+			decoder.Fail(v8::Exception::TypeError, "Unexpected data after encoded value");
+		return Wrap(context, tryCatch, value);
+	});
+}
+
+// -------------------------------------------------------------------------
+// Shapes
+struct JSShape
+{
+	struct Field
+	{
+		ResettingPersistent<v8::String> Key;
+		JSFieldType Type;
+		int Offset;
+	};
+	SnapshotHandle Tracked;
+	std::vector<Field> Fields;
+	int Size;
+
+	JSShape(JSContext* context) : Tracked(context->Isolate) { }
+};
+
+static int FieldSize(JSFieldType type)
+{
+	switch (type)
+	{
+		case JSFieldType::Int8: case JSFieldType::UInt8: case JSFieldType::Bool: return 1;
+		case JSFieldType::Int16: case JSFieldType::UInt16: return 2;
+		case JSFieldType::Int32: case JSFieldType::UInt32: case JSFieldType::Float: return 4;
+		case JSFieldType::Double: return 8;
+	}
+	return 0;
+}
+
+template<typename T>
+static inline void StoreField(uint8_t* field, T value) { memcpy(field, &value, sizeof(value)); }
+
+template<typename T>
+static inline T LoadField(const uint8_t* field)
+{
+	T value;
+	memcpy(&value, field, sizeof(value));
+	return value;
+}
+
+static void ReadStruct(JSContext* context, const v8::TryCatch& tryCatch, JSShape* shape, v8::Local<v8::Object> obj, uint8_t* out)
+{
+	auto localContext = context->LocalHandle();
+	for (auto& field : shape->Fields)
+	{
+		auto value = FromJust(context, tryCatch, obj->Get(localContext, field.Key.Get(context->Isolate)));
+		auto p = out + field.Offset;
+		switch (field.Type)
+		{
+			case JSFieldType::Bool:
+				StoreField<uint8_t>(p, value->BooleanValue(localContext).FromMaybe(false) ? 1 : 0);
+				break;
+			case JSFieldType::Float:
+				StoreField<float>(p, static_cast<float>(FromJust(context, tryCatch, value->NumberValue(localContext))));
+				break;
+			case JSFieldType::Double:
+				StoreField<double>(p, FromJust(context, tryCatch, value->NumberValue(localContext)));
+				break;
+			default:
+			{
+				auto i = FromJust(context, tryCatch, value->Int32Value(localContext));
+				switch (field.Type)
+				{
+					case JSFieldType::Int8: StoreField<int8_t>(p, static_cast<int8_t>(i)); break;
+					case JSFieldType::UInt8: StoreField<uint8_t>(p, static_cast<uint8_t>(i)); break;
+					case JSFieldType::Int16: StoreField<int16_t>(p, static_cast<int16_t>(i)); break;
+					case JSFieldType::UInt16: StoreField<uint16_t>(p, static_cast<uint16_t>(i)); break;
+					case JSFieldType::Int32: StoreField<int32_t>(p, i); break;
+					default: StoreField<uint32_t>(p, static_cast<uint32_t>(i)); break;
+				}
+				break;
+			}
+		}
+	}
+}
+
+static v8::Local<v8::Object> CreateStructObject(JSContext* context, const v8::TryCatch& tryCatch, JSShape* shape, const uint8_t* data)
+{
+	auto isolate = context->Isolate;
+	auto localContext = context->LocalHandle();
+	auto obj = v8::Object::New(isolate);
+	for (auto& field : shape->Fields)
+	{
+		auto p = data + field.Offset;
+		v8::Local<v8::Value> value;
+		switch (field.Type)
+		{
+			case JSFieldType::Int8: value = v8::Integer::New(isolate, LoadField<int8_t>(p)); break;
+			case JSFieldType::UInt8: value = v8::Integer::New(isolate, LoadField<uint8_t>(p)); break;
+			case JSFieldType::Int16: value = v8::Integer::New(isolate, LoadField<int16_t>(p)); break;
+			case JSFieldType::UInt16: value = v8::Integer::New(isolate, LoadField<uint16_t>(p)); break;
+			case JSFieldType::Int32: value = v8::Integer::New(isolate, LoadField<int32_t>(p)); break;
+			case JSFieldType::UInt32: value = v8::Integer::NewFromUnsigned(isolate, LoadField<uint32_t>(p)); break;
+			case JSFieldType::Float: value = v8::Number::New(isolate, LoadField<float>(p)); break;
+			case JSFieldType::Double: value = v8::Number::New(isolate, LoadField<double>(p)); break;
+			case JSFieldType::Bool: value = v8::Boolean::New(isolate, LoadField<uint8_t>(p) != 0); break;
+		}
+		FromJust(context, tryCatch, obj->CreateDataProperty(localContext, field.Key.Get(isolate), value));
+	}
+	return obj;
+}
+
+DllPublic JSShape* CDecl CreateJSShape(JSContext* context, const uint16_t* const* names, const JSFieldType* types, const int* offsets, int fieldCount, int structSize, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (!IsOwnerThread(context))
+	{
+		*outError = JSRuntimeError::WrongThread;
+		return nullptr;
+	}
+	for (int i = 0; i < fieldCount; ++i)
+	{
+		auto size = FieldSize(types[i]);
+		if (size == 0 || offsets[i] < 0 || offsets[i] + size > structSize)
+		{
+			*outError = JSRuntimeError::TypeError;
+			return nullptr;
+		}
+	}
+
+	V8Scope scope(context);
+	auto shape = new JSShape(context);
+	shape->Size = structSize;
+	shape->Fields.resize(fieldCount);
+	for (int i = 0; i < fieldCount; ++i)
+	{
+		auto key = v8::String::NewFromTwoByte(
+			context->Isolate,
+			names[i],
+			v8::NewStringType::kInternalized);
+		if (key.IsEmpty())
+		{
+			delete shape;
+			*outError = JSRuntimeError::StringTooLong;
+			return nullptr;
+		}
+		auto& field = shape->Fields[i];
+		field.Key.Reset(context->Isolate, key.ToLocalChecked());
+		field.Type = types[i];
+		field.Offset = offsets[i];
+	}
+	return shape;
+}
+
+DllPublic void CDecl ReleaseJSShape(JSContext* context, JSShape* shape)
+{
+	if (shape != nullptr && context != nullptr)
+		ReleaseOnOwnerThread(context, [shape] { delete shape; });
+}
+
+DllPublic void CDecl ReadJSStruct(JSContext* context, JSShape* shape, JSObject* obj, void* outStruct, JSScriptException** outError)
+{
+	TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		ReadStruct(context, tryCatch, shape, obj->LocalHandle(context), static_cast<uint8_t*>(outStruct));
+	});
+}
+
+DllPublic JSObject* CDecl CreateJSStructObject(JSContext* context, JSShape* shape, const void* data, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return new JSObject(context->Isolate, CreateStructObject(context, tryCatch, shape, static_cast<const uint8_t*>(data)));
+	});
+}
+
+DllPublic int CDecl ReadJSStructArray(JSContext* context, JSShape* shape, JSArray* arr, void* outStructs, int capacity, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		auto localContext = context->LocalHandle();
+		auto localArr = arr->LocalHandle(context);
+		auto length = static_cast<int>(localArr->Length());
+		auto count = std::min(length, capacity);
+		auto out = static_cast<uint8_t*>(outStructs);
+		for (int i = 0; i < count; ++i)
+		{
+			v8::HandleScope handleScope(context->Isolate);
+			auto element = FromJust(context, tryCatch, localArr->Get(localContext, static_cast<uint32_t>(i)));
+			auto obj = FromJust(context, tryCatch, element->ToObject(localContext));
+			ReadStruct(context, tryCatch, shape, obj, out + i * shape->Size);
+		}
+		return length;
+	});
+}
+
+DllPublic JSArray* CDecl CreateJSStructArray(JSContext* context, JSShape* shape, const void* structs, int count, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		auto localContext = context->LocalHandle();
+		auto arr = v8::Array::New(context->Isolate, count);
+		auto data = static_cast<const uint8_t*>(structs);
+		for (int i = 0; i < count; ++i)
+		{
+			v8::HandleScope handleScope(context->Isolate);
+			FromJust(context, tryCatch, arr->CreateDataProperty(
+				localContext,
+				static_cast<uint32_t>(i),
+				CreateStructObject(context, tryCatch, shape, data + i * shape->Size)));
+		}
+		return new JSArray(context->Isolate, arr);
+	});
+}
+
+// -------------------------------------------------------------------------
+// Shared ring buffer
+// Single-producer, single-consumer byte ring in shared memory. The header is
+// four int32s (head, tail, capacity, reserved) that both sides only access
+// atomically, followed by capacity bytes of data. One byte is always left
+// free so that head == tail means empty.
+static const int RingBufferHeaderSize = 16;
+enum { RingBufferHead, RingBufferTail, RingBufferCapacity };
+
+static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t), "Ring buffer header must be plain int32s");
+
+static inline std::atomic<int32_t>* RingBufferHeader(void* memory)
+{
+	return reinterpret_cast<std::atomic<int32_t>*>(memory);
+}
+
+static inline uint8_t* RingBufferData(void* memory)
+{
+	return static_cast<uint8_t*>(memory) + RingBufferHeaderSize;
+}
+
+// Scripts can write anything to the header, so it is checked against the
+// memory the host actually has before it is used to index the data
+static inline bool IsValidRingBuffer(int byteLength, int32_t capacity, int32_t head, int32_t tail)
+{
+	return byteLength > RingBufferHeaderSize
+		&& capacity > 0 && capacity <= byteLength - RingBufferHeaderSize
+		&& head >= 0 && head < capacity
+		&& tail >= 0 && tail < capacity;
+}
+
+static const char* const RingBufferSource = R"(
+(function (global) {
+	var HEAD = 0, TAIL = 1, CAPACITY = 2, HEADER_SIZE = 16;
+
+	function SharedRingBuffer(buffer) {
+		this.header = new Int32Array(buffer, 0, 4);
+		this.capacity = Atomics.load(this.header, CAPACITY);
+		this.data = new Uint8Array(buffer, HEADER_SIZE, this.capacity);
+	}
+
+	SharedRingBuffer.prototype.available = function () {
+		var head = Atomics.load(this.header, HEAD);
+		var tail = Atomics.load(this.header, TAIL);
+		return (head - tail + this.capacity) % this.capacity;
+	};
+
+	SharedRingBuffer.prototype.write = function (bytes) {
+		var head = Atomics.load(this.header, HEAD);
+		var tail = Atomics.load(this.header, TAIL);
+		var count = Math.min(bytes.length, (tail - head - 1 + this.capacity) % this.capacity);
+		var first = Math.min(count, this.capacity - head);
+		this.data.set(bytes.subarray(0, first), head);
+		this.data.set(bytes.subarray(first, count), 0);
+		Atomics.store(this.header, HEAD, (head + count) % this.capacity);
+		return count;
+	};
+
+	SharedRingBuffer.prototype.read = function (target) {
+		var head = Atomics.load(this.header, HEAD);
+		var tail = Atomics.load(this.header, TAIL);
+		var count = Math.min(target.length, (head - tail + this.capacity) % this.capacity);
+		var first = Math.min(count, this.capacity - tail);
+		target.set(this.data.subarray(tail, tail + first), 0);
+		target.set(this.data.subarray(0, count - first), first);
+		Atomics.store(this.header, TAIL, (tail + count) % this.capacity);
+		return count;
+	};
+
+	global.SharedRingBuffer = SharedRingBuffer;
+})(this);
+)";
+
+DllPublic int CDecl JSRingBufferByteLength(int capacity) { return RingBufferHeaderSize + capacity; }
+
+DllPublic void CDecl InitializeJSRingBuffer(void* memory, int capacity)
+{
+	auto header = RingBufferHeader(memory);
+	header[RingBufferHead].store(0);
+	header[RingBufferTail].store(0);
+	header[RingBufferCapacity].store(capacity);
+	header[RingBufferCapacity + 1].store(0);
+}
+
+DllPublic int CDecl WriteJSRingBuffer(void* memory, int byteLength, const void* data, int length)
+{
+	auto header = RingBufferHeader(memory);
+	auto capacity = header[RingBufferCapacity].load(std::memory_order_relaxed);
+	auto head = header[RingBufferHead].load(std::memory_order_relaxed);
+	auto tail = header[RingBufferTail].load(std::memory_order_acquire);
+	if (length < 0 || !IsValidRingBuffer(byteLength, capacity, head, tail))
+		return -1;
+	auto count = std::min(length, (tail - head - 1 + capacity) % capacity);
+	auto first = std::min(count, capacity - head);
+	auto bytes = static_cast<const uint8_t*>(data);
+	memcpy(RingBufferData(memory) + head, bytes, first);
+	memcpy(RingBufferData(memory), bytes + first, count - first);
+	header[RingBufferHead].store((head + count) % capacity, std::memory_order_release);
+	return count;
+}
+
+DllPublic int CDecl ReadJSRingBuffer(void* memory, int byteLength, void* outData, int length)
+{
+	auto header = RingBufferHeader(memory);
+	auto capacity = header[RingBufferCapacity].load(std::memory_order_relaxed);
+	auto tail = header[RingBufferTail].load(std::memory_order_relaxed);
+	auto head = header[RingBufferHead].load(std::memory_order_acquire);
+	if (length < 0 || !IsValidRingBuffer(byteLength, capacity, head, tail))
+		return -1;
+	auto count = std::min(length, (head - tail + capacity) % capacity);
+	auto first = std::min(count, capacity - tail);
+	auto bytes = static_cast<uint8_t*>(outData);
+	memcpy(bytes, RingBufferData(memory) + tail, first);
+	memcpy(bytes + first, RingBufferData(memory), count - first);
+	header[RingBufferTail].store((tail + count) % capacity, std::memory_order_release);
+	return count;
+}
+
+DllPublic void CDecl InstallJSRingBuffer(JSContext* context, JSScriptException** outError)
+{
+	TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		auto localContext = context->LocalHandle();
+		auto script = FromJust(context, tryCatch, v8::Script::Compile(
+			localContext,
+			v8::String::NewFromUtf8(context->Isolate, RingBufferSource)));
+		FromJust(context, tryCatch, script->Run(localContext));
+	});
+}
+
+// -------------------------------------------------------------------------
+// Serialization
+struct JSSerializedValue : RefCounted
+{
+	SerializedValue Value;
+};
+
+DllPublic JSSerializedValue* CDecl SerializeJSValueCreate(JSContext* context, JSValue* value, JSArray* transfer, void* hostData, JSHostObjectWriter hostObjectWriter, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		HostObjectHooks hooks{context, hostData, hostObjectWriter, nullptr};
+		auto result = new JSSerializedValue();
+		if (!Serialize(
+			context->Isolate,
+			context->LocalHandle(),
+			Unwrap(context->Isolate, value),
+			transfer == nullptr ? v8::Local<v8::Array>() : transfer->LocalHandle(context),
+			result->Value,
+			&hooks))
+		{
+			result->Release();
+			Throw(context, tryCatch);
+		}
+		return result;
+	});
+}
+
+DllPublic JSValue* CDecl DeserializeJSValueCreate(JSContext* context, JSSerializedValue* serialized, void* hostData, JSHostObjectReader hostObjectReader, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		HostObjectHooks hooks{context, hostData, nullptr, hostObjectReader};
+		return WrapMaybe(
+			context,
+			tryCatch,
+			Deserialize(context->Isolate, context->LocalHandle(), serialized->Value, &hooks));
+	});
+}
+
+DllPublic JSSerializedValue* CDecl CreateJSSerializedValue(const void* data, int length)
+{
+	auto result = new JSSerializedValue();
+	auto bytes = static_cast<const uint8_t*>(data);
+	result->Value.Data.assign(bytes, bytes + length);
+	return result;
+}
+
+DllPublic void CDecl RetainJSSerializedValue(JSSerializedValue* serialized)
+{
+	if (serialized != nullptr)
+		serialized->Retain();
+}
+
+DllPublic void CDecl ReleaseJSSerializedValue(JSSerializedValue* serialized)
+{
+	if (serialized != nullptr)
+		serialized->Release();
+}
+
+DllPublic const void* CDecl GetJSSerializedValueData(JSSerializedValue* serialized) { return data_ptr(serialized->Value.Data); }
+DllPublic int CDecl GetJSSerializedValueLength(JSSerializedValue* serialized) { return static_cast<int>(serialized->Value.Data.size()); }
+
+// -------------------------------------------------------------------------
+// WebAssembly
+// V8 only exposes compilation and instantiation through the JS API, so we
+// go through the WebAssembly constructors
+static v8::Local<v8::Function> WebAssemblyConstructor(JSContext* context, const v8::TryCatch& tryCatch, const char* name)
+{
+	auto localContext = context->LocalHandle();
+	auto webAssembly = FromJust(context, tryCatch, localContext->Global()->Get(
+		localContext,
+		v8::String::NewFromUtf8(context->Isolate, "WebAssembly")));
+	if (!webAssembly->IsObject())
+		ThrowTypeError(context, tryCatch, "WebAssembly is not available");
+	auto constructor = FromJust(context, tryCatch, webAssembly.As<v8::Object>()->Get(
+		localContext,
+		v8::String::NewFromUtf8(context->Isolate, name)));
+	if (!constructor->IsFunction())
+		ThrowTypeError(context, tryCatch, "WebAssembly is not available");
+	return constructor.As<v8::Function>();
+}
+
+DllPublic JSObject* CDecl CompileJSWasmModule(JSContext* context, const void* bytes, int length, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		auto buffer = v8::ArrayBuffer::New(context->Isolate, length);
+		memcpy(buffer->GetContents().Data(), bytes, length);
+		v8::Local<v8::Value> args[] = { buffer };
+		return new JSObject(context->Isolate, FromJust(context, tryCatch,
+			WebAssemblyConstructor(context, tryCatch, "Module")->NewInstance(context->LocalHandle(), 1, args)));
+	});
+}
+
+DllPublic JSObject* CDecl InstantiateJSWasmModule(JSContext* context, JSObject* module, JSObject* imports, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		v8::Local<v8::Value> args[] = { module->LocalHandle(context), Unwrap(context->Isolate, imports) };
+		return new JSObject(context->Isolate, FromJust(context, tryCatch,
+			WebAssemblyConstructor(context, tryCatch, "Instance")->NewInstance(
+				context->LocalHandle(),
+				imports == nullptr ? 1 : 2,
+				args)));
+	});
+}
+
+DllPublic JSSerializedValue* CDecl SerializeJSWasmModuleCreate(JSContext* context, JSObject* module, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		auto localModule = module->LocalHandle(context);
+		if (!localModule->IsWebAssemblyCompiledModule())
+			ThrowTypeError(context, tryCatch, "Expected a WebAssembly.Module");
+		auto serialized = localModule.As<v8::WasmCompiledModule>()->Serialize();
+		auto result = new JSSerializedValue();
+		result->Value.Data.assign(serialized.first.get(), serialized.first.get() + serialized.second);
+		return result;
+	});
+}
+
+DllPublic JSObject* CDecl DeserializeJSWasmModule(JSContext* context, JSSerializedValue* serialized, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch) -> JSObject*
+	{
+		auto& data = serialized->Value.Data;
+		std::unique_ptr<uint8_t[]> bytes(new uint8_t[data.size()]);
+		std::copy(data.begin(), data.end(), bytes.get());
+		v8::WasmCompiledModule::SerializedModule serializedModule(std::move(bytes), data.size());
+		v8::Local<v8::WasmCompiledModule> module;
+		if (!v8::WasmCompiledModule::Deserialize(context->Isolate, serializedModule).ToLocal(&module))
+			return nullptr;
+		return new JSObject(context->Isolate, module);
+	});
+}
+
+// -------------------------------------------------------------------------
+// Worker
+struct WorkerMessage
+{
+	SerializedValue Value;
+	bool IsError;
+	WorkerMessage() : IsError(false) { }
+};
+
+struct JSWorker : RefCounted
+{
+	const std::vector<uint16_t> FileName;
+	const std::vector<uint16_t> Code;
+	void* const NotifierData;
+	const JSWorkerMessageNotifier Notifier;
+
+	MPSCQueue<std::unique_ptr<WorkerMessage>> Inbox;
+	MPSCQueue<std::unique_ptr<WorkerMessage>> Outbox;
+	WakeSignal InboxSignal;
+
+	// Guards Context and Stopping so that a worker stuck in a script can be
+	// terminated when it is released.
+	std::mutex StateMutex;
+	JSContext* Context;
+	std::atomic<bool> Stopping;
+
+	std::thread Thread;
+
+	JSWorker(
+		const uint16_t* fileName,
+		int fileNameLength,
+		const uint16_t* code,
+		int codeLength,
+		void* notifierData,
+		JSWorkerMessageNotifier notifier)
+		: FileName(fileName, fileName + fileNameLength)
+		, Code(code, code + codeLength)
+		, NotifierData(notifierData)
+		, Notifier(notifier)
+		, Context(nullptr)
+		, Stopping(false)
+	{
+		// The thread keeps its own reference, so that the host can release the
+		// worker from the notifier without the thread outliving it
+		Retain();
+		Thread = std::thread([this] { Run(); });
+	}
+
+	virtual ~JSWorker() override
+	{
+		// The last reference is dropped on the worker thread when the host
+		// released it first, as the last thing the thread does
+		if (Thread.get_id() == std::this_thread::get_id())
+			Thread.detach();
+		else
+			Thread.join();
+	}
+
+	void Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(StateMutex);
+			Stopping = true;
+			if (Context != nullptr)
+				Context->Isolate->TerminateExecution();
+		}
+		InboxSignal.Notify();
+	}
+
+	void Post(std::unique_ptr<WorkerMessage> message)
+	{
+		Inbox.Push(std::move(message));
+		InboxSignal.Notify();
+	}
+
+	void Reply(std::unique_ptr<WorkerMessage> message)
+	{
+		Outbox.Push(std::move(message));
+		if (Notifier != nullptr)
+			Notifier(NotifierData);
+	}
+
+	// Reports an uncaught exception in the worker to the host as a string
+	// message.
+	void ReplyError(JSContext* context, JSScriptException* error)
+	{
+		auto isolate = context->Isolate;
+		v8::HandleScope handleScope(isolate);
+		auto text = v8::String::Concat(
+			error->ErrorMessage->LocalHandle(isolate),
+			v8::String::Concat(
+				v8::String::NewFromUtf8(isolate, "\n"),
+				error->StackTrace->LocalHandle(isolate)));
+		error->Release();
+
+		std::unique_ptr<WorkerMessage> message(new WorkerMessage());
+		message->IsError = true;
+		if (Serialize(isolate, context->LocalHandle(), text, v8::Local<v8::Array>(), message->Value))
+			Reply(std::move(message));
+	}
+
+	static void PostMessageCallback(const v8::FunctionCallbackInfo<v8::Value>& info)
+	{
+		auto worker = static_cast<JSWorker*>(info.Data().As<v8::External>()->Value());
+		auto isolate = info.GetIsolate();
+		v8::HandleScope handleScope(isolate);
+
+		v8::Local<v8::Array> transferList;
+		if (info.Length() > 1 && info[1]->IsArray())
+			transferList = info[1].As<v8::Array>();
+
+		std::unique_ptr<WorkerMessage> message(new WorkerMessage());
+		if (Serialize(isolate, isolate->GetCurrentContext(), info[0], transferList, message->Value))
+			worker->Reply(std::move(message));
+	}
+
+	void Run()
+	{
+		auto context = new JSContext(nullptr, nullptr, true);
+		{
+			std::lock_guard<std::mutex> lock(StateMutex);
+			if (!Stopping)
+				Context = context;
+		}
+
+		if (Context != nullptr)
+		{
+			V8Scope scope(context);
+			try
+			{
+				v8::TryCatch tryCatch;
+				auto localContext = context->LocalHandle();
+				auto postMessage = FromJust(context, tryCatch, v8::Function::New(
+					localContext,
+					PostMessageCallback,
+					v8::External::New(context->Isolate, this)));
+				FromJust(context, tryCatch, localContext->Global()->Set(
+					localContext,
+					v8::String::NewFromUtf8(context->Isolate, "postMessage"),
+					postMessage));
+
+				auto fileName = FromJust(context, tryCatch, v8::String::NewFromTwoByte(
+					context->Isolate,
+					data_ptr(FileName),
+					v8::NewStringType::kNormal,
+					static_cast<int>(FileName.size())));
+				auto code = FromJust(context, tryCatch, v8::String::NewFromTwoByte(
+					context->Isolate,
+					data_ptr(Code),
+					v8::NewStringType::kNormal,
+					static_cast<int>(Code.size())));
+				v8::ScriptOrigin origin(fileName);
+				auto script = FromJust(context, tryCatch, v8::Script::Compile(localContext, code, &origin));
+				FromJust(context, tryCatch, script->Run(localContext));
+			}
+			catch (JSScriptException* error)
+			{
+				if (!Stopping)
+					ReplyError(context, error);
+				else
+					error->Release();
+			}
+		}
+
+		while (!Stopping)
+		{
+			if (!Inbox.IsEmpty())
+			{
+				V8Scope scope(context);
+				std::unique_ptr<WorkerMessage> message;
+				while (!Stopping && Inbox.Pop(message))
+					Dispatch(context, *message);
+			}
+			InboxSignal.Wait([this] { return Stopping || !Inbox.IsEmpty(); });
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(StateMutex);
+			Context = nullptr;
+		}
+		context->Release();
+		Release();
+	}
+
+	void Dispatch(JSContext* context, WorkerMessage& message)
+	{
+		v8::HandleScope handleScope(context->Isolate);
+		try
+		{
+			v8::TryCatch tryCatch;
+			auto localContext = context->LocalHandle();
+			auto value = FromJust(context, tryCatch, Deserialize(context->Isolate, localContext, message.Value));
+			auto onMessage = FromJust(context, tryCatch, localContext->Global()->Get(
+				localContext,
+				v8::String::NewFromUtf8(context->Isolate, "onmessage")));
+			if (onMessage->IsFunction())
+			{
+				v8::Local<v8::Value> args[] = { value };
+				FromJust(context, tryCatch, onMessage.As<v8::Function>()->Call(localContext, localContext->Global(), 1, args));
+			}
+		}
+		catch (JSScriptException* error)
+		{
+			if (!Stopping)
+				ReplyError(context, error);
+			else
+				error->Release();
+		}
+	}
+};
+
+DllPublic JSWorker* CDecl CreateJSWorker(
+	const uint16_t* fileName,
+	int fileNameLength,
+	const uint16_t* code,
+	int codeLength,
+	void* notifierData,
+	JSWorkerMessageNotifier notifier)
+{
+	return new JSWorker(fileName, fileNameLength, code, codeLength, notifierData, notifier);
+}
+
+DllPublic void CDecl ReleaseJSWorker(JSWorker* worker)
+{
+	if (worker != nullptr)
+	{
+		worker->Stop();
+		worker->Release();
+	}
+}
+
+DllPublic void CDecl PostJSWorkerMessage(JSContext* context, JSWorker* worker, JSValue* message, JSArray* transfer, JSScriptException** outError)
+{
+	TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		std::unique_ptr<WorkerMessage> workerMessage(new WorkerMessage());
+		if (!Serialize(
+			context->Isolate,
+			context->LocalHandle(),
+			Unwrap(context->Isolate, message),
+			transfer == nullptr ? v8::Local<v8::Array>() : transfer->LocalHandle(context),
+			workerMessage->Value))
+		{
+			Throw(context, tryCatch);
+		}
+		worker->Post(std::move(workerMessage));
+	});
+}
+
+DllPublic bool CDecl TryReceiveJSWorkerMessage(JSContext* context, JSWorker* worker, JSValue** outMessage, bool* outIsError, JSScriptException** outError)
+{
+	*outMessage = nullptr;
+	*outIsError = false;
+	*outError = nullptr;
+	// Checked before popping, so that the message isn't lost
+	if (!IsOwnerThread(context))
+	{
+		*outError = WrongThreadException(context);
+		return false;
+	}
+	std::unique_ptr<WorkerMessage> message;
+	if (!worker->Outbox.Pop(message))
+		return false;
+	*outIsError = message->IsError;
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		*outMessage = WrapMaybe(
+			context,
+			tryCatch,
+			Deserialize(context->Isolate, context->LocalHandle(), message->Value));
+		return true;
+	});
+}
+
+// -------------------------------------------------------------------------
+// Parallel map
+struct JSParallelPool : RefCounted
+{
+	// The chunks [Begin, End) that a thread has left to process, packed into one
+	// word so that the owner (taking from the front) and thieves (taking the
+	// back half) can update it with a single compare-and-swap.
+	struct ChunkRange
+	{
+		std::atomic<uint64_t> Packed;
+
+		ChunkRange() : Packed(0) { }
+
+		static uint64_t Pack(uint32_t begin, uint32_t end) { return (static_cast<uint64_t>(begin) << 32) | end; }
+		static uint32_t Begin(uint64_t packed) { return static_cast<uint32_t>(packed >> 32); }
+		static uint32_t End(uint64_t packed) { return static_cast<uint32_t>(packed); }
+
+		void Reset(uint32_t begin, uint32_t end) { Packed.store(Pack(begin, end)); }
+
+		bool TakeFront(uint32_t& outChunk)
+		{
+			auto packed = Packed.load();
+			while (Begin(packed) < End(packed))
+			{
+				if (Packed.compare_exchange_weak(packed, Pack(Begin(packed) + 1, End(packed))))
+				{
+					outChunk = Begin(packed);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool StealBack(uint32_t& outBegin, uint32_t& outEnd)
+		{
+			auto packed = Packed.load();
+			while (Begin(packed) < End(packed))
+			{
+				auto middle = Begin(packed) + (End(packed) - Begin(packed)) / 2;
+				if (Packed.compare_exchange_weak(packed, Pack(Begin(packed), middle)))
+				{
+					outBegin = middle;
+					outEnd = End(packed);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		uint32_t Size()
+		{
+			auto packed = Packed.load();
+			return Begin(packed) < End(packed) ? End(packed) - Begin(packed) : 0;
+		}
+	};
+
+	struct Job
+	{
+		const uint8_t* Input;
+		int InputStride;
+		uint8_t* Output;
+		int OutputStride;
+		int Count;
+		int ChunkSize;
+	};
+
+	struct Thread
+	{
+		JSParallelPool* Pool;
+		ChunkRange Chunks;
+		WakeSignal Signal;
+		std::thread Handle;
+	};
+
+	std::vector<std::unique_ptr<Thread>> Threads;
+	const std::vector<uint16_t> Code;
+	const std::vector<uint16_t> FunctionName;
+
+	// Map calls are serialized; Job and Generation are published to the pool
+	// threads through the generation counter.
+	std::mutex MapMutex;
+	Job CurrentJob;
+	std::atomic<uint64_t> Generation;
+	std::atomic<bool> Stopping;
+
+	std::mutex DoneMutex;
+	std::condition_variable DoneCondition;
+	size_t Busy;
+
+	// Failed is per map, while Broken means that the script itself failed
+	std::atomic<bool> Failed;
+	bool Broken;
+	std::mutex ErrorMutex;
+	std::vector<uint16_t> Error;
+
+	JSParallelPool(int threadCount, const uint16_t* code, int codeLength, const uint16_t* functionName, int functionNameLength)
+		: Code(code, code + codeLength)
+		, FunctionName(functionName, functionName + functionNameLength)
+		, Generation(0)
+		, Stopping(false)
+		, Busy(0)
+		, Failed(false)
+		, Broken(false)
+	{
+		if (threadCount <= 0)
+			threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+		// Wait for all threads to be warmed up before accepting work
+		Busy = threadCount;
+		for (int i = 0; i < threadCount; ++i)
+		{
+			auto thread = new Thread();
+			thread->Pool = this;
+			Threads.emplace_back(thread);
+		}
+		for (auto& thread : Threads)
+		{
+			auto t = thread.get();
+			t->Handle = std::thread([this, t] { Run(*t); });
+		}
+		WaitUntilDone();
+		Broken = Failed;
+	}
+
+	virtual ~JSParallelPool() override
+	{
+		Stopping = true;
+		for (auto& thread : Threads)
+		{
+			thread->Signal.Notify();
+			thread->Handle.join();
+		}
+	}
+
+	void WaitUntilDone()
+	{
+		std::unique_lock<std::mutex> lock(DoneMutex);
+		DoneCondition.wait(lock, [this] { return Busy == 0; });
+	}
+
+	void FinishedWork()
+	{
+		std::lock_guard<std::mutex> lock(DoneMutex);
+		if (--Busy == 0)
+			DoneCondition.notify_all();
+	}
+
+	void Fail(JSContext* context, JSScriptException* error)
+	{
+		if (!Failed.exchange(true))
+		{
+			std::lock_guard<std::mutex> lock(ErrorMutex);
+			v8::HandleScope handleScope(context->Isolate);
+			auto message = error->ErrorMessage->LocalHandle(context);
+			Error.resize(message->Length());
+			message->Write(data_ptr(Error), 0, -1, v8::String::NO_NULL_TERMINATION);
+		}
+		error->Release();
+	}
+
+	bool Map(const void* input, int inputStride, void* output, int outputStride, int count)
+	{
+		std::lock_guard<std::mutex> mapLock(MapMutex);
+		if (Broken)
+			return false;
+		if (count <= 0)
+			return true;
+		Failed = false;
+		{
+			std::lock_guard<std::mutex> lock(ErrorMutex);
+			Error.clear();
+		}
+
+		// Several chunks per thread leaves room for stealing to even out the load
+		auto threadCount = static_cast<int>(Threads.size());
+		auto chunkSize = std::max(1, count / (threadCount * 8));
+		auto chunkCount = (count + chunkSize - 1) / chunkSize;
+		CurrentJob = Job{static_cast<const uint8_t*>(input), inputStride, static_cast<uint8_t*>(output), outputStride, count, chunkSize};
+
+		for (int i = 0; i < threadCount; ++i)
+		{
+			Threads[i]->Chunks.Reset(
+				static_cast<uint32_t>(static_cast<int64_t>(chunkCount) * i / threadCount),
+				static_cast<uint32_t>(static_cast<int64_t>(chunkCount) * (i + 1) / threadCount));
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(DoneMutex);
+			Busy = Threads.size();
+		}
+		++Generation;
+		for (auto& thread : Threads)
+			thread->Signal.Notify();
+		WaitUntilDone();
+		return !Failed;
+	}
+
+	bool NextChunk(Thread& thread, uint32_t& outChunk)
+	{
+		if (thread.Chunks.TakeFront(outChunk))
+			return true;
+
+		// Steal half of the largest remaining range
+		while (!Failed)
+		{
+			Thread* victim = nullptr;
+			uint32_t victimSize = 0;
+			for (auto& other : Threads)
+			{
+				auto size = other->Chunks.Size();
+				if (size > victimSize)
+				{
+					victim = other.get();
+					victimSize = size;
+				}
+			}
+			if (victim == nullptr)
+				return false;
+
+			uint32_t begin, end;
+			if (victim->Chunks.StealBack(begin, end))
+			{
+				thread.Chunks.Reset(begin + 1, end);
+				outChunk = begin;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void RunChunk(JSContext* context, v8::Local<v8::Function> function, uint32_t chunk)
+	{
+		auto isolate = context->Isolate;
+		auto localContext = context->LocalHandle();
+		auto& job = CurrentJob;
+		auto begin = static_cast<int>(chunk) * job.ChunkSize;
+		auto end = std::min(job.Count, begin + job.ChunkSize);
+		auto records = end - begin;
+
+		v8::HandleScope handleScope(isolate);
+		auto input = v8::ArrayBuffer::New(
+			isolate,
+			const_cast<uint8_t*>(job.Input) + static_cast<size_t>(begin) * job.InputStride,
+			static_cast<size_t>(records) * job.InputStride);
+		v8::Local<v8::ArrayBuffer> output;
+		if (job.Output != nullptr)
+		{
+			output = v8::ArrayBuffer::New(
+				isolate,
+				job.Output + static_cast<size_t>(begin) * job.OutputStride,
+				static_cast<size_t>(records) * job.OutputStride);
+		}
+
+		try
+		{
+			v8::TryCatch tryCatch;
+			for (int i = 0; i < records && !Failed; ++i)
+			{
+				v8::HandleScope recordScope(isolate);
+				v8::Local<v8::Value> args[] =
+				{
+					v8::DataView::New(input, static_cast<size_t>(i) * job.InputStride, job.InputStride),
+					output.IsEmpty()
+						? v8::Undefined(isolate).As<v8::Value>()
+						: v8::DataView::New(output, static_cast<size_t>(i) * job.OutputStride, job.OutputStride).As<v8::Value>(),
+					v8::Integer::New(isolate, begin + i),
+				};
+				FromJust(context, tryCatch, function->Call(localContext, v8::Undefined(isolate), 3, args));
+			}
+		}
+		catch (JSScriptException* error)
+		{
+			Fail(context, error);
+		}
+
+		// Don't let scripts hold on to host memory after the map returns
+		if (input->IsNeuterable())
+			input->Neuter();
+		if (!output.IsEmpty() && output->IsNeuterable())
+			output->Neuter();
+	}
+
+	void Run(Thread& thread)
+	{
+		auto context = new JSContext(nullptr, nullptr, true);
+		ResettingPersistent<v8::Function> function;
+		{
+			V8Scope scope(context);
+			try
+			{
+				v8::TryCatch tryCatch;
+				auto localContext = context->LocalHandle();
+				auto code = FromJust(context, tryCatch, v8::String::NewFromTwoByte(
+					context->Isolate,
+					data_ptr(Code),
+					v8::NewStringType::kNormal,
+					static_cast<int>(Code.size())));
+				auto script = FromJust(context, tryCatch, v8::Script::Compile(localContext, code));
+				FromJust(context, tryCatch, script->Run(localContext));
+
+				auto name = FromJust(context, tryCatch, v8::String::NewFromTwoByte(
+					context->Isolate,
+					data_ptr(FunctionName),
+					v8::NewStringType::kInternalized,
+					static_cast<int>(FunctionName.size())));
+				auto value = FromJust(context, tryCatch, localContext->Global()->Get(localContext, name));
+				if (!value->IsFunction())
+				{
+					context->Isolate->ThrowException(v8::Exception::TypeError(
+						v8::String::NewFromUtf8(context->Isolate, "Parallel map function is not defined")));
+					Throw(context, tryCatch);
+				}
+				function.Reset(context->Isolate, value.As<v8::Function>());
+			}
+			catch (JSScriptException* error)
+			{
+				Fail(context, error);
+			}
+		}
+		FinishedWork();
+
+		uint64_t seenGeneration = 0;
+		while (true)
+		{
+			thread.Signal.Wait([&] { return Stopping || Generation != seenGeneration; });
+			if (Stopping)
+				break;
+			seenGeneration = Generation;
+
+			if (!function.IsEmpty())
+			{
+				V8Scope scope(context);
+				auto localFunction = function.Get(context->Isolate);
+				uint32_t chunk;
+				while (!Failed && NextChunk(thread, chunk))
+					RunChunk(context, localFunction, chunk);
+			}
+			FinishedWork();
+		}
+
+		function.Reset();
+		context->Release();
+	}
+};
+
+DllPublic JSParallelPool* CDecl CreateJSParallelPool(int threadCount, const uint16_t* code, int codeLength, const uint16_t* functionName, int functionNameLength)
+{
+	return new JSParallelPool(threadCount, code, codeLength, functionName, functionNameLength);
+}
+
+DllPublic void CDecl ReleaseJSParallelPool(JSParallelPool* pool)
+{
+	if (pool != nullptr)
+		pool->Release();
+}
+
+DllPublic void CDecl JSParallelMap(JSParallelPool* pool, const void* input, int inputStride, void* output, int outputStride, int count, JSRuntimeError* outError)
+{
+	*outError = pool->Map(input, inputStride, output, outputStride, count)
+		? JSRuntimeError::NoError
+		: JSRuntimeError::ScriptError;
+}
+
+DllPublic int CDecl JSParallelPoolErrorLength(JSParallelPool* pool)
+{
+	std::lock_guard<std::mutex> lock(pool->ErrorMutex);
+	return static_cast<int>(pool->Error.size());
+}
+
+DllPublic void CDecl WriteJSParallelPoolErrorBuffer(JSParallelPool* pool, uint16_t* outBuffer, bool nullTerminate)
+{
+	std::lock_guard<std::mutex> lock(pool->ErrorMutex);
+	std::copy(pool->Error.begin(), pool->Error.end(), outBuffer);
+	if (nullTerminate)
+		outBuffer[pool->Error.size()] = 0;
+}
+
+
+// -------------------------------------------------------------------------
+// Stack sampler
+// Samples are folded stacks (outermost frame first, separated by ';') in a
+// fixed ring of fixed-size slots. The sampled threads claim slots with a
+// ticket and publish them with a sequence lock, so recording never blocks
+// and the oldest samples are simply overwritten.
+struct SampleRing : RefCounted
+{
+	struct Slot
+	{
+		std::atomic<uint64_t> Sequence;
+		std::atomic<int> Length;
+	};
+
+	const int Capacity;
+	const int MaxFrames;
+	const int SlotSize;
+	std::unique_ptr<Slot[]> Slots;
+	std::unique_ptr<char[]> Data;
+	std::atomic<uint64_t> NextTicket;
+	std::atomic<uint64_t> ClearedTicket;
+
+	SampleRing(int capacity, int maxFrames, int slotSize)
+		: Capacity(capacity)
+		, MaxFrames(maxFrames)
+		, SlotSize(slotSize)
+		, Slots(new Slot[capacity])
+		, Data(new char[static_cast<size_t>(capacity) * slotSize])
+		, NextTicket(0)
+		, ClearedTicket(0)
+	{
+		for (int i = 0; i < capacity; ++i)
+		{
+			Slots[i].Sequence = 0;
+			Slots[i].Length = 0;
+		}
+	}
+
+	// Called on the sampled thread, from an interrupt
+	void Record(v8::Isolate* isolate)
+	{
+		v8::HandleScope handleScope(isolate);
+		auto trace = v8::StackTrace::CurrentStackTrace(
+			isolate,
+			MaxFrames,
+			static_cast<v8::StackTrace::StackTraceOptions>(
+				v8::StackTrace::kFunctionName | v8::StackTrace::kScriptName | v8::StackTrace::kLineNumber));
+		auto frameCount = trace->GetFrameCount();
+		if (frameCount == 0)
+			return;
+
+		auto ticket = NextTicket.fetch_add(1);
+		auto index = static_cast<int>(ticket % Capacity);
+		auto& slot = Slots[index];
+		auto data = &Data[static_cast<size_t>(index) * SlotSize];
+		// A writer a whole ring behind or ahead of us may have the same slot.
+		// Only claim it from a published, older sample, and otherwise drop ours
+		auto sequence = slot.Sequence.load(std::memory_order_relaxed);
+		do
+		{
+			if ((sequence & 1) != 0 || sequence > 2 * ticket)
+				return;
+		}
+		while (!slot.Sequence.compare_exchange_weak(sequence, 2 * ticket + 1, std::memory_order_relaxed));
+		std::atomic_thread_fence(std::memory_order_release);
+
+		int length = 0;
+		auto append = [&] (const char* text, int textLength)
+		{
+			auto n = std::min(textLength, SlotSize - length);
+			memcpy(data + length, text, n);
+			length += n;
+		};
+		auto appendString = [&] (v8::Local<v8::String> string)
+		{
+			if (string.IsEmpty() || length >= SlotSize)
+				return false;
+			auto written = string->WriteUtf8(
+				data + length,
+				SlotSize - length,
+				nullptr,
+				v8::String::NO_NULL_TERMINATION | v8::String::REPLACE_INVALID_UTF8);
+			// Names can't contain the separators of the folded format
+			std::replace(data + length, data + length + written, ';', ',');
+			std::replace(data + length, data + length + written, '\n', ' ');
+			length += written;
+			return written > 0;
+		};
+		for (int i = frameCount - 1; i >= 0; --i)
+		{
+			auto frame = trace->GetFrame(static_cast<uint32_t>(i));
+			if (i != frameCount - 1)
+				append(";", 1);
+			if (!appendString(frame->GetFunctionName()))
+				append("(anonymous)", 11);
+			append(" (", 2);
+			appendString(frame->GetScriptName());
+			char line[16];
+			append(line, snprintf(line, sizeof(line), ":%d)", frame->GetLineNumber()));
+		}
+
+		slot.Length.store(length, std::memory_order_relaxed);
+		slot.Sequence.store(2 * ticket + 2, std::memory_order_release);
+	}
+
+	void Collect(std::map<std::string, int>& outCounts)
+	{
+		std::vector<char> buffer(SlotSize);
+		auto cleared = ClearedTicket.load();
+		for (int i = 0; i < Capacity; ++i)
+		{
+			auto& slot = Slots[i];
+			auto before = slot.Sequence.load(std::memory_order_acquire);
+			if (before == 0 || (before & 1) != 0 || (before - 2) / 2 < cleared)
+				continue;
+			auto length = std::min(slot.Length.load(std::memory_order_relaxed), SlotSize);
+			memcpy(data_ptr(buffer), &Data[static_cast<size_t>(i) * SlotSize], length);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.Sequence.load(std::memory_order_relaxed) != before)
+				continue;
+			++outCounts[std::string(data_ptr(buffer), length)];
+		}
+	}
+};
+
+struct SampleRequest : RefCounted
+{
+	SampleRing* const Ring;
+	std::atomic<bool> Pending;
+	// Set when the context is removed from the sampler, so that an interrupt
+	// that is still pending doesn't record
+	std::atomic<bool> Cancelled;
+
+	SampleRequest(SampleRing* ring) : Ring(ring), Pending(false), Cancelled(false) { Ring->Retain(); }
+	virtual ~SampleRequest() override { Ring->Release(); }
+
+	// Called with the sampler's lock held
+	void Request(JSContext* context)
+	{
+		if (Pending.exchange(true))
+			return;
+		Retain();
+		{
+			std::lock_guard<std::mutex> lock(context->InterruptsMutex);
+			context->PendingInterrupts.push_back(this);
+		}
+		context->Isolate->RequestInterrupt(Interrupt, this);
+	}
+
+	static void Interrupt(v8::Isolate* isolate, void* data)
+	{
+		auto request = static_cast<SampleRequest*>(data);
+		auto context = static_cast<JSContext*>(isolate->GetData(0));
+		{
+			std::lock_guard<std::mutex> lock(context->InterruptsMutex);
+			auto& pending = context->PendingInterrupts;
+			pending.erase(std::find(pending.begin(), pending.end(), request));
+		}
+		if (!request->Cancelled)
+			request->Ring->Record(isolate);
+		request->Pending = false;
+		request->Release();
+	}
+};
+
+struct JSStackSampler
+{
+	typedef std::chrono::steady_clock Clock;
+
+	struct Entry
+	{
+		JSContext* Context;
+		Clock::duration Interval;
+		Clock::time_point Next;
+		SampleRequest* Request;
+	};
+
+	SampleRing* const Ring;
+	std::mutex Mutex;
+	std::condition_variable Wake;
+	std::vector<Entry> Entries;
+	bool Stopping;
+	std::thread Thread;
+
+	JSStackSampler(int capacity, int maxFrames, int maxStackLength)
+		: Ring(new SampleRing(capacity, maxFrames, maxStackLength))
+		, Stopping(false)
+	{
+		Thread = std::thread([this] { Run(); });
+	}
+
+	~JSStackSampler()
+	{
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			Stopping = true;
+		}
+		Wake.notify_one();
+		Thread.join();
+		for (auto& entry : Entries)
+		{
+			entry.Request->Cancelled = true;
+			entry.Request->Release();
+			ReleaseJSContext(entry.Context);
+		}
+		// Interrupts that are still pending keep the ring alive
+		Ring->Release();
+	}
+
+	void Run()
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		while (!Stopping)
+		{
+			auto now = Clock::now();
+			auto next = now + std::chrono::seconds(1);
+			for (auto& entry : Entries)
+			{
+				if (entry.Next <= now)
+				{
+					// Only contexts that are running are sampled, and each has at
+					// most one request in flight
+					if (entry.Context->Isolate->IsInUse())
+						entry.Request->Request(entry.Context);
+					entry.Next = now + entry.Interval;
+				}
+				next = std::min(next, entry.Next);
+			}
+			Wake.wait_until(lock, next);
+		}
+	}
+};
+
+DllPublic JSStackSampler* CDecl CreateJSStackSampler(int capacity, int maxFrames, int maxStackLength)
+{
+	return new JSStackSampler(std::max(capacity, 1), std::max(maxFrames, 1), std::max(maxStackLength, 16));
+}
+
+DllPublic void CDecl ReleaseJSStackSampler(JSStackSampler* sampler)
+{
+	delete sampler;
+}
+
+DllPublic void CDecl AddJSStackSamplerContext(JSStackSampler* sampler, JSContext* context, double hz)
+{
+	auto interval = std::chrono::duration_cast<JSStackSampler::Clock::duration>(
+		std::chrono::duration<double>(1.0 / std::min(std::max(hz, 1.0), 1000.0)));
+	{
+		std::lock_guard<std::mutex> lock(sampler->Mutex);
+		for (auto& entry : sampler->Entries)
+		{
+			if (entry.Context == context)
+			{
+				entry.Interval = interval;
+				entry.Next = JSStackSampler::Clock::now();
+				return;
+			}
+		}
+		context->Retain();
+		sampler->Entries.push_back(JSStackSampler::Entry{
+			context,
+			interval,
+			JSStackSampler::Clock::now(),
+			new SampleRequest(sampler->Ring)});
+	}
+	sampler->Wake.notify_one();
+}
+
+DllPublic void CDecl RemoveJSStackSamplerContext(JSStackSampler* sampler, JSContext* context)
+{
+	JSStackSampler::Entry removed{nullptr, {}, {}, nullptr};
+	{
+		std::lock_guard<std::mutex> lock(sampler->Mutex);
+		auto& entries = sampler->Entries;
+		auto it = std::find_if(entries.begin(), entries.end(), [&] (const JSStackSampler::Entry& entry)
+		{
+			return entry.Context == context;
+		});
+		if (it == entries.end())
+			return;
+		removed = *it;
+		entries.erase(it);
+	}
+	// A pending interrupt still holds the request, until it runs or the
+	// context goes away
+	removed.Request->Cancelled = true;
+	removed.Request->Release();
+	ReleaseJSContext(removed.Context);
+}
+
+DllPublic void CDecl ClearJSStackSampler(JSStackSampler* sampler)
+{
+	sampler->Ring->ClearedTicket = sampler->Ring->NextTicket.load();
+}
+
+DllPublic int CDecl WriteJSStackSamplerFolded(JSStackSampler* sampler, char* outBuffer, int bufferLength)
+{
+	std::map<std::string, int> counts;
+	sampler->Ring->Collect(counts);
+	std::string folded;
+	for (auto& count : counts)
+		folded.append(count.first).append(" ").append(std::to_string(count.second)).append("\n");
+	auto length = static_cast<int>(folded.size());
+	if (length <= bufferLength)
+		std::copy(folded.begin(), folded.end(), outBuffer);
+	return length;
+}
+
+// -------------------------------------------------------------------------
+// Scheduler
+// Work is queued per context. A context's virtual time is the time it has
+// spent running, scaled by the priority of what it ran. A context with queued
+// work that isn't running waits in a heap ordered by its turn: its virtual
+// time plus a quantum scaled by the priority of its next item, so that high
+// priority work goes ahead of low priority work that was ready at the same
+// virtual time, without starving it. A separate watchdog thread terminates
+// work that overruns its budget.
+struct JSScheduler
+{
+	typedef std::chrono::steady_clock Clock;
+
+	struct Work
+	{
+		void* Data;
+		JSScheduledWork Callback;
+		JSSchedulerPriority Priority;
+		Clock::duration Budget;
+		Clock::time_point Queued;
+	};
+
+	struct Tenant
+	{
+		JSContext* Context;
+		std::deque<Work> Queue;
+		uint64_t VirtualTime;
+		uint64_t Turn;
+		bool Running;
+		Clock::time_point Deadline;
+		bool Terminated;
+	};
+
+	static bool LaterTurn(const Tenant* a, const Tenant* b) { return a->Turn > b->Turn; }
+
+	static const uint64_t QuantumNanos = 1000000;
+
+	static uint64_t PriorityCost(JSSchedulerPriority priority)
+	{
+		switch (priority)
+		{
+			case JSSchedulerPriority::Low: return 16;
+			case JSSchedulerPriority::High: return 1;
+			default: return 4;
+		}
+	}
+
+	std::mutex Mutex;
+	std::condition_variable WorkCondition;
+	std::condition_variable WatchdogCondition;
+	std::map<JSContext*, Tenant*> Tenants;
+	std::vector<Tenant*> Ready;
+	std::vector<Tenant*> Watched;
+	uint64_t MinVirtualTime;
+	bool Stopping;
+
+	int QueueDepth;
+	uint64_t StartedCount;
+	uint64_t TotalWaitNanos;
+	uint64_t MaxWaitNanos;
+	uint64_t TerminatedCount;
+
+	std::vector<std::thread> Threads;
+	std::thread Watchdog;
+
+	JSScheduler(int threadCount)
+		: MinVirtualTime(0)
+		, Stopping(false)
+		, QueueDepth(0)
+		, StartedCount(0)
+		, TotalWaitNanos(0)
+		, MaxWaitNanos(0)
+		, TerminatedCount(0)
+	{
+		if (threadCount <= 0)
+			threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+		for (int i = 0; i < threadCount; ++i)
+			Threads.emplace_back([this] { Run(); });
+		Watchdog = std::thread([this] { Watch(); });
+	}
+
+	~JSScheduler()
+	{
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			Stopping = true;
+			for (auto tenant : Tenants)
+			{
+				if (tenant.second->Running)
+					tenant.second->Context->Isolate->TerminateExecution();
+			}
+		}
+		WorkCondition.notify_all();
+		WatchdogCondition.notify_all();
+		for (auto& thread : Threads)
+			thread.join();
+		Watchdog.join();
+
+		for (auto tenant : Tenants)
+		{
+			for (auto& work : tenant.second->Queue)
+				work.Callback(work.Data, tenant.first, true);
+			ReleaseJSContext(tenant.first);
+			delete tenant.second;
+		}
+	}
+
+	// Call with Mutex held
+	void MakeReady(Tenant* tenant)
+	{
+		// A context that has been idle doesn't get to catch up on its share
+		tenant->VirtualTime = std::max(tenant->VirtualTime, MinVirtualTime);
+		tenant->Turn = tenant->VirtualTime + QuantumNanos * PriorityCost(tenant->Queue.front().Priority);
+		Ready.push_back(tenant);
+		std::push_heap(Ready.begin(), Ready.end(), LaterTurn);
+		WorkCondition.notify_one();
+	}
+
+	void Post(JSContext* context, JSSchedulerPriority priority, int budgetMilliseconds, void* data, JSScheduledWork callback)
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		if (Stopping || context->SingleOwner)
+		{
+			lock.unlock();
+			callback(data, context, true);
+			return;
+		}
+
+		auto& tenant = Tenants[context];
+		if (tenant == nullptr)
+		{
+			context->Retain();
+			tenant = new Tenant{context, {}, 0, 0, false, {}, false};
+		}
+		tenant->Queue.push_back(Work{
+			data,
+			callback,
+			priority,
+			std::chrono::milliseconds(std::max(budgetMilliseconds, 0)),
+			Clock::now()});
+		++QueueDepth;
+		if (tenant->Queue.size() == 1 && !tenant->Running)
+			MakeReady(tenant);
+	}
+
+	void Run()
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		while (true)
+		{
+			WorkCondition.wait(lock, [this] { return Stopping || !Ready.empty(); });
+			if (Stopping)
+				break;
+
+			std::pop_heap(Ready.begin(), Ready.end(), LaterTurn);
+			auto tenant = Ready.back();
+			Ready.pop_back();
+			MinVirtualTime = std::max(MinVirtualTime, tenant->VirtualTime);
+
+			auto work = tenant->Queue.front();
+			tenant->Queue.pop_front();
+			--QueueDepth;
+			tenant->Running = true;
+			tenant->Terminated = false;
+
+			auto started = Clock::now();
+			auto waitNanos = static_cast<uint64_t>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(started - work.Queued).count());
+			++StartedCount;
+			TotalWaitNanos += waitNanos;
+			MaxWaitNanos = std::max(MaxWaitNanos, waitNanos);
+			if (work.Budget != Clock::duration::zero())
+			{
+				tenant->Deadline = started + work.Budget;
+				Watched.push_back(tenant);
+				WatchdogCondition.notify_one();
+			}
+			lock.unlock();
+
+			auto context = tenant->Context;
+			{
+				V8Scope scope(context);
+				work.Callback(work.Data, context, false);
+
+				lock.lock();
+				Watched.erase(std::remove(Watched.begin(), Watched.end(), tenant), Watched.end());
+				// A termination that hasn't hit yet mustn't hit the next work
+				if (tenant->Terminated || Stopping)
+					context->Isolate->CancelTerminateExecution();
+				lock.unlock();
+			}
+
+			auto elapsedNanos = static_cast<uint64_t>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started).count());
+			lock.lock();
+			tenant->Running = false;
+			tenant->VirtualTime += elapsedNanos * PriorityCost(work.Priority);
+			if (!tenant->Queue.empty())
+			{
+				if (!Stopping)
+					MakeReady(tenant);
+			}
+			else
+			{
+				Tenants.erase(context);
+				delete tenant;
+				lock.unlock();
+				ReleaseJSContext(context);
+				lock.lock();
+			}
+		}
+	}
+
+	void Watch()
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		while (!Stopping)
+		{
+			auto now = Clock::now();
+			auto next = now + std::chrono::seconds(1);
+			for (auto tenant : Watched)
+			{
+				if (tenant->Terminated)
+					continue;
+				if (tenant->Deadline <= now)
+				{
+					tenant->Terminated = true;
+					++TerminatedCount;
+					tenant->Context->Isolate->TerminateExecution();
+				}
+				else
+				{
+					next = std::min(next, tenant->Deadline);
+				}
+			}
+			WatchdogCondition.wait_until(lock, next);
+		}
+	}
+};
+
+DllPublic JSScheduler* CDecl CreateJSScheduler(int threadCount)
+{
+	return new JSScheduler(threadCount);
+}
+
+DllPublic void CDecl ReleaseJSScheduler(JSScheduler* scheduler)
+{
+	delete scheduler;
+}
+
+DllPublic void CDecl PostJSSchedulerWork(JSScheduler* scheduler, JSContext* context, JSSchedulerPriority priority, int budgetMilliseconds, void* data, JSScheduledWork work)
+{
+	scheduler->Post(context, priority, budgetMilliseconds, data, work);
+}
+
+DllPublic int CDecl GetJSSchedulerQueueDepth(JSScheduler* scheduler)
+{
+	std::lock_guard<std::mutex> lock(scheduler->Mutex);
+	return scheduler->QueueDepth;
+}
+
+DllPublic int CDecl GetJSSchedulerContextQueueDepth(JSScheduler* scheduler, JSContext* context)
+{
+	std::lock_guard<std::mutex> lock(scheduler->Mutex);
+	auto it = scheduler->Tenants.find(context);
+	return it == scheduler->Tenants.end() ? 0 : static_cast<int>(it->second->Queue.size());
+}
+
+DllPublic uint64_t CDecl GetJSSchedulerStartedCount(JSScheduler* scheduler)
+{
+	std::lock_guard<std::mutex> lock(scheduler->Mutex);
+	return scheduler->StartedCount;
+}
+
+DllPublic uint64_t CDecl GetJSSchedulerTotalWaitTime(JSScheduler* scheduler)
+{
+	std::lock_guard<std::mutex> lock(scheduler->Mutex);
+	return scheduler->TotalWaitNanos;
+}
+
+DllPublic uint64_t CDecl GetJSSchedulerMaxWaitTime(JSScheduler* scheduler)
+{
+	std::lock_guard<std::mutex> lock(scheduler->Mutex);
+	return scheduler->MaxWaitNanos;
+}
+
+DllPublic uint64_t CDecl GetJSSchedulerTerminatedCount(JSScheduler* scheduler)
+{
+	std::lock_guard<std::mutex> lock(scheduler->Mutex);
+	return scheduler->TerminatedCount;
+}
+
+// -------------------------------------------------------------------------
+// Executor
+struct ExecutorJob
+{
+	void* Data;
+	JSScheduledWork Work;
+	JSExecutorCompletion Completion;
+	std::vector<uint16_t> FileName;
+	std::vector<uint16_t> Code;
+};
+
+struct JSExecutor
+{
+	JSContext* const Context;
+	void* const NotifierData;
+	const JSExecutorNotifier Notifier;
+	MPSCQueue<std::unique_ptr<ExecutorJob>> Queue;
+
+	JSExecutor(JSContext* context, void* notifierData, JSExecutorNotifier notifier)
+		: Context(context)
+		, NotifierData(notifierData)
+		, Notifier(notifier)
+	{
+		Context->Retain();
+	}
+
+	~JSExecutor()
+	{
+		std::unique_ptr<ExecutorJob> job;
+		while (Queue.Pop(job))
+		{
+			if (job->Work != nullptr)
+				job->Work(job->Data, Context, true);
+			else
+				job->Completion(job->Data, Context, nullptr, nullptr, true);
+		}
+		ReleaseJSContext(Context);
+	}
+
+	void Submit(std::unique_ptr<ExecutorJob> job)
+	{
+		Queue.Push(std::move(job));
+		if (Notifier != nullptr)
+			Notifier(NotifierData);
+	}
+
+	void Run(const V8Scope& scope, ExecutorJob& job)
+	{
+		if (job.Work != nullptr)
+		{
+			job.Work(job.Data, Context, false);
+			return;
+		}
+
+		v8::HandleScope handleScope(Context->Isolate);
+		JSScriptException* error;
+		auto result = TryCatch(&error, scope, [&] (v8::TryCatch& tryCatch)
+		{
+			auto localContext = Context->LocalHandle();
+			auto fileName = FromJust(Context, tryCatch, v8::String::NewFromTwoByte(
+				Context->Isolate,
+				data_ptr(job.FileName),
+				v8::NewStringType::kNormal,
+				static_cast<int>(job.FileName.size())));
+			auto code = FromJust(Context, tryCatch, v8::String::NewFromTwoByte(
+				Context->Isolate,
+				data_ptr(job.Code),
+				v8::NewStringType::kNormal,
+				static_cast<int>(job.Code.size())));
+			v8::ScriptOrigin origin(fileName);
+			auto script = FromJust(Context, tryCatch, v8::Script::Compile(localContext, code, &origin));
+			return WrapMaybe(Context, tryCatch, script->Run(localContext));
+		});
+		job.Completion(job.Data, Context, result, error, false);
+	}
+
+	int Pump(int maxJobs)
+	{
+		if (!IsOwnerThread(Context))
+			return -1;
+		if (Queue.IsEmpty())
+			return 0;
+
+		V8Scope scope(Context);
+		int count = 0;
+		std::unique_ptr<ExecutorJob> job;
+		while ((maxJobs <= 0 || count < maxJobs) && Queue.Pop(job))
+		{
+			Run(scope, *job);
+			++count;
+		}
+		return count;
+	}
+};
+
+DllPublic JSExecutor* CDecl CreateJSExecutor(JSContext* context, void* notifierData, JSExecutorNotifier notifier)
+{
+	return new JSExecutor(context, notifierData, notifier);
+}
+
+DllPublic void CDecl ReleaseJSExecutor(JSExecutor* executor)
+{
+	delete executor;
+}
+
+DllPublic void CDecl SubmitJSExecutorWork(JSExecutor* executor, void* data, JSScheduledWork work)
+{
+	executor->Submit(std::unique_ptr<ExecutorJob>(new ExecutorJob{data, work, nullptr, {}, {}}));
+}
+
+DllPublic void CDecl SubmitJSExecutorScript(JSExecutor* executor, const uint16_t* fileName, int fileNameLength, const uint16_t* code, int codeLength, void* data, JSExecutorCompletion completion)
+{
+	executor->Submit(std::unique_ptr<ExecutorJob>(new ExecutorJob{
+		data,
+		nullptr,
+		completion,
+		std::vector<uint16_t>(fileName, fileName + fileNameLength),
+		std::vector<uint16_t>(code, code + codeLength)}));
+}
+
+DllPublic int CDecl PumpJSExecutor(JSExecutor* executor, int maxJobs)
+{
+	return executor->Pump(maxJobs);
+}
 
 // -------------------------------------------------------------------------
 // Exceptions
@@ -963,7 +5388,6 @@ DllPublic void CDecl RetainJSScriptException(JSContext* context, JSScriptExcepti
 {
 	if (e != nullptr)
 	{
-		v8::Locker(context->Isolate);
 		e->Retain();
 	}
 }
@@ -971,8 +5395,7 @@ DllPublic void CDecl ReleaseJSScriptException(JSContext* context, JSScriptExcept
 {
 	if (e != nullptr)
 	{
-		v8::Locker(context->Isolate);
-		e->Release();
+		ReleaseOnOwnerThread(context, [e] { e->Release(); });
 	}
 }
 DllPublic JSValue* CDecl GetJSScriptException(JSScriptException* e) { return e->Exception; }
@@ -16,6 +16,8 @@ public enum JSType
 	Array,
 	Function,
 	External,
+	Map,
+	Set,
 }
 public enum JSRuntimeError
 {
@@ -23,6 +25,46 @@ public enum JSRuntimeError
 	InvalidCast,
 	StringTooLong,
 	TypeError,
+	ScriptError,
+	WrongThread,
+}
+public enum JSEngineProfile
+{
+	Default,
+	LowLatency,
+	Throughput,
+	LowMemory,
+}
+public enum JSRAILMode
+{
+	Response,
+	Animation,
+	Idle,
+	Load,
+}
+public enum JSMemoryPressure
+{
+	None,
+	Moderate,
+	Critical,
+}
+public enum JSFieldType
+{
+	Int8,
+	UInt8,
+	Int16,
+	UInt16,
+	Int32,
+	UInt32,
+	Float,
+	Double,
+	Bool,
+}
+public enum JSSchedulerPriority
+{
+	Low,
+	Normal,
+	High,
 }
 [StructLayout(LayoutKind.Sequential)]
 public struct JSContext
@@ -60,6 +102,66 @@ public struct JSExternal
 	readonly IntPtr _handle;
 }
 [StructLayout(LayoutKind.Sequential)]
+public struct JSWorker
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSSerializedValue
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSParallelPool
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSShape
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSSnapshot
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSStackSampler
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSScheduler
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSExecutor
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSEntries
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSEntriesCursor
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSArrayCursor
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSPropertyAccessor
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
 public struct JSScriptException
 {
 	readonly IntPtr _handle;
@@ -72,6 +174,13 @@ public delegate JSValue JSCallback(JSContext context, IntPtr data, [In, MarshalA
 public delegate void JSExternalFinalizer(IntPtr external);
 public delegate void JSCallbackFinalizer(IntPtr data);
 public delegate void JSDebugMessageHandler(IntPtr data, JSString message);
+public delegate void JSWorkerMessageNotifier(IntPtr data);
+[return: MarshalAs(UnmanagedType.I1)]
+public delegate bool JSHostObjectWriter(IntPtr data, JSContext context, JSObject obj, out ulong id);
+public delegate JSObject JSHostObjectReader(IntPtr data, JSContext context, ulong id);
+public delegate void JSScheduledWork(IntPtr data, JSContext context, [MarshalAs(UnmanagedType.I1)]bool cancelled);
+public delegate void JSExecutorNotifier(IntPtr data);
+public delegate void JSExecutorCompletion(IntPtr data, JSContext context, JSValue result, JSScriptException error, [MarshalAs(UnmanagedType.I1)]bool cancelled);
 // -------------------------------------------------------------------------
 // Context
 public static class Context
@@ -82,24 +191,87 @@ public static extern void Retain(JSContext context);
 public static extern void Release(JSContext context);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSContext")]
 public static extern JSContext Create([MarshalAs(UnmanagedType.FunctionPtr)]JSCallbackFinalizer callbackFinalizer, [MarshalAs(UnmanagedType.FunctionPtr)]JSExternalFinalizer externalFinalizer);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSContextSingleOwner")]
+public static extern JSContext CreateSingleOwner([MarshalAs(UnmanagedType.FunctionPtr)]JSCallbackFinalizer callbackFinalizer, [MarshalAs(UnmanagedType.FunctionPtr)]JSExternalFinalizer externalFinalizer);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSContextFromSnapshot")]
+public static extern JSContext CreateFromSnapshot([MarshalAs(UnmanagedType.FunctionPtr)]JSCallbackFinalizer callbackFinalizer, [MarshalAs(UnmanagedType.FunctionPtr)]JSExternalFinalizer externalFinalizer, JSSnapshot snapshot);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSContextEvaluateCreate")]
 public static extern JSValue EvaluateCreate(JSContext context, JSString fileName, JSString code, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSContextEvaluateBatch")]
+public static extern int EvaluateBatch(JSContext context, [In, MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPWStr)]string[] fileNames, [In, MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPWStr)]string[] codes, int count, [MarshalAs(UnmanagedType.I1)]bool continueOnError, [Out]JSScriptException[] errors);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSContextCopyGlobalObject")]
-public static extern JSObject CopyGlobalObject(JSContext context);
+public static extern JSObject CopyGlobalObject(JSContext context, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ConfigureJSEngine")]
+[return: MarshalAs(UnmanagedType.I1)]
+public static extern bool ConfigureEngine(JSEngineProfile profile, [MarshalAs(UnmanagedType.LPStr)]string flags);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSContextRAILMode")]
+public static extern void SetRAILMode(JSContext context, JSRAILMode mode, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSContextInBackground")]
+public static extern void SetInBackground(JSContext context, [MarshalAs(UnmanagedType.I1)]bool inBackground, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="NotifyJSContextMemoryPressure")]
+public static extern void NotifyMemoryPressure(JSContext context, JSMemoryPressure level);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="NotifyJSMemoryPressure")]
+public static extern void NotifyMemoryPressure(JSMemoryPressure level);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSContextCpuAccounting")]
+public static extern void SetCpuAccounting(JSContext context, [MarshalAs(UnmanagedType.I1)]bool enabled);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSContextCpuTime")]
+public static extern ulong GetCpuTime(JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSContextHostCpuTime")]
+public static extern ulong GetHostCpuTime(JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ResetJSContextCpuTime")]
+public static extern void ResetCpuTime(JSContext context);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetV8Version")]
 public static extern IntPtr GetV8VersionPtr();
 public static string GetV8Version() { return Marshal.PtrToStringAnsi(GetV8VersionPtr()); }
 }
 // -------------------------------------------------------------------------
+// Snapshots
+public static class Snapshot
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSSnapshot")]
+public static extern JSSnapshot Create([MarshalAs(UnmanagedType.LPStr)]string embeddedSource);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WarmUpJSSnapshot")]
+public static extern JSSnapshot WarmUp(JSSnapshot coldSnapshot, [MarshalAs(UnmanagedType.LPStr)]string warmupSource);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSSnapshotFromData")]
+public static extern JSSnapshot CreateFromData([In]byte[] data, int length);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSSnapshot")]
+public static extern void Retain(JSSnapshot snapshot);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSSnapshot")]
+public static extern void Release(JSSnapshot snapshot);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSnapshotData")]
+public static extern IntPtr GetData(JSSnapshot snapshot);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSnapshotLength")]
+public static extern int GetLength(JSSnapshot snapshot);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSWarmSnapshotFile")]
+[return: MarshalAs(UnmanagedType.I1)]
+public static extern bool WriteWarmFile([MarshalAs(UnmanagedType.LPStr)]string embeddedSource, [MarshalAs(UnmanagedType.LPStr)]string warmupSource, [MarshalAs(UnmanagedType.LPStr)]string path);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSSnapshotContext")]
+public static extern JSContext CreateContext([MarshalAs(UnmanagedType.FunctionPtr)]JSCallbackFinalizer callbackFinalizer, [MarshalAs(UnmanagedType.FunctionPtr)]JSExternalFinalizer externalFinalizer);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSSnapshotFromContext")]
+public static extern JSSnapshot CreateFromContext(JSContext context, [MarshalAs(UnmanagedType.I1)]bool keepCompiledCode, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSHostFunction")]
+public static extern JSFunction CreateHostFunction(JSContext context, uint id, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="BindJSHostFunction")]
+public static extern void BindHostFunction(JSContext context, uint id, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSCallback callback, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSHostObject")]
+public static extern JSObject CreateHostObject(JSContext context, uint id, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="BindJSHostObject")]
+public static extern void BindHostObject(JSContext context, uint id, IntPtr value, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSHostObjectId")]
+public static extern uint GetHostObjectId(JSContext context, JSObject obj, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSHostObjectValue")]
+public static extern IntPtr GetHostObjectValue(JSContext context, JSObject obj, out JSRuntimeError error);
+}
+// -------------------------------------------------------------------------
 // Debug
 public static class Debug
 {
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSDebugMessageHandler")]
-public static extern void SetMessageHandler(JSContext context, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSDebugMessageHandler messageHandler);
+public static extern void SetMessageHandler(JSContext context, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSDebugMessageHandler messageHandler, out JSRuntimeError error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SendJSDebugCommand")]
 public static extern void SendCommand(JSContext context, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string command, int length);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ProcessJSDebugMessages")]
-public static extern void ProcessMessages(JSContext context);
+public static extern void ProcessMessages(JSContext context, out JSRuntimeError error);
 }
 // -------------------------------------------------------------------------
 // Value
@@ -130,7 +302,7 @@ public static extern JSFunction AsFunction(JSValue value, out JSRuntimeError err
 public static extern JSExternal AsExternal(JSValue value, out JSRuntimeError error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSValueStrictEquals")]
 [return: MarshalAs(UnmanagedType.I1)]
-public static extern bool StrictEquals(JSContext context, JSValue obj1, JSValue obj2);
+public static extern bool StrictEquals(JSContext context, JSValue obj1, JSValue obj2, out JSRuntimeError error);
 // --------------------------------------------------------------------------
 // Primitives
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSNull")]
@@ -142,7 +314,9 @@ public static extern JSValue CreateDouble(double value);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSBool")]
 public static extern JSValue CreateBool([MarshalAs(UnmanagedType.I1)]bool value);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateExternalJSArrayBuffer")]
-public static extern JSObject CreateExternalArrayBuffer(JSContext context, IntPtr data, int byteLength);
+public static extern JSObject CreateExternalArrayBuffer(JSContext context, IntPtr data, int byteLength, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateExternalJSSharedArrayBuffer")]
+public static extern JSObject CreateExternalSharedArrayBuffer(JSContext context, IntPtr data, int byteLength, out JSRuntimeError error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSCallback")]
 public static extern JSFunction CreateCallback(JSContext context, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSCallback callback, out JSScriptException error);
 // --------------------------------------------------------------------------
@@ -150,13 +324,17 @@ public static extern JSFunction CreateCallback(JSContext context, IntPtr data, [
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSString")]
 public static extern JSString CreateString(JSContext context, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string buffer, int length, out JSRuntimeError error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSStringLength")]
-public static extern int Length(JSContext context, JSString str);
+public static extern int Length(JSContext context, JSString str, out JSRuntimeError error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSStringBuffer")]
-public static extern void Write(JSContext context, JSString str, [Out, MarshalAs(UnmanagedType.LPWStr)]StringBuilder buffer, [MarshalAs(UnmanagedType.I1)]bool nullTerminate);
+public static extern void Write(JSContext context, JSString str, [Out, MarshalAs(UnmanagedType.LPWStr)]StringBuilder buffer, [MarshalAs(UnmanagedType.I1)]bool nullTerminate, out JSRuntimeError error);
 public static string ToString(JSContext context, JSString str)
 {
-	var sb = new StringBuilder(Length(context, str) + 1);
-	Write(context, str, sb, true);
+	JSRuntimeError error;
+	var length = Length(context, str, out error);
+	if (error != JSRuntimeError.NoError)
+		return null;
+	var sb = new StringBuilder(length + 1);
+	Write(context, str, sb, true, out error);
 	return sb.ToString();
 }
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSStringAsValue")]
@@ -167,6 +345,14 @@ public static extern JSValue AsValue(JSString str);
 public static extern JSValue CopyProperty(JSContext context, JSObject obj, JSString key, out JSScriptException error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSObjectProperty")]
 public static extern void SetProperty(JSContext context, JSObject obj, JSString key, JSValue value, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSObjectPropertyDouble")]
+public static extern void SetPropertyDouble(JSContext context, JSObject obj, JSString key, double value, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSObjectPropertyInt")]
+public static extern void SetPropertyInt(JSContext context, JSObject obj, JSString key, int value, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSObjectPropertyBool")]
+public static extern void SetPropertyBool(JSContext context, JSObject obj, JSString key, [MarshalAs(UnmanagedType.I1)]bool value, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSObjectPropertyUtf8")]
+public static extern void SetPropertyUtf8(JSContext context, JSObject obj, JSString key, [In]byte[] value, int length, out JSScriptException error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSObjectOwnPropertyNames")]
 public static extern JSArray CopyOwnPropertyNames(JSContext context, JSObject obj, out JSScriptException error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSObjectHasProperty")]
@@ -174,6 +360,26 @@ public static extern JSArray CopyOwnPropertyNames(JSContext context, JSObject ob
 public static extern bool HasProperty(JSContext context, JSObject obj, JSString key, out JSScriptException error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectArrayBufferData")]
 public static extern IntPtr GetArrayBufferData(JSContext context, JSObject obj, out JSRuntimeError outError);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectPropertyAsDouble")]
+public static extern double GetPropertyAsDouble(JSContext context, JSObject obj, JSString key, out JSRuntimeError error, out JSScriptException scriptError);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectPropertyAsInt")]
+public static extern int GetPropertyAsInt(JSContext context, JSObject obj, JSString key, out JSRuntimeError error, out JSScriptException scriptError);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectPropertyAsBool")]
+[return: MarshalAs(UnmanagedType.I1)]
+public static extern bool GetPropertyAsBool(JSContext context, JSObject obj, JSString key, out JSRuntimeError error, out JSScriptException scriptError);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectPropertyAsString")]
+public static extern int GetPropertyAsString(JSContext context, JSObject obj, JSString key, [Out]char[] buffer, int bufferLength, out JSRuntimeError error, out JSScriptException scriptError);
+public static string GetPropertyAsString(JSContext context, JSObject obj, JSString key, out JSRuntimeError error, out JSScriptException scriptError)
+{
+	var buffer = new char[64];
+	var length = GetPropertyAsString(context, obj, key, buffer, buffer.Length, out error, out scriptError);
+	if (length > buffer.Length)
+	{
+		buffer = new char[length];
+		length = GetPropertyAsString(context, obj, key, buffer, buffer.Length, out error, out scriptError);
+	}
+	return new string(buffer, 0, length);
+}
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSObjectAsValue")]
 public static extern JSValue AsValue(JSObject obj);
 // -------------------------------------------------------------------------
@@ -182,11 +388,42 @@ public static extern JSValue AsValue(JSObject obj);
 public static extern JSValue CopyProperty(JSContext context, JSArray arr, int index, out JSScriptException error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSArrayPropertyAtIndex")]
 public static extern void SetProperty(JSContext context, JSArray arr, int index, JSValue value, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSArrayPropertyAtIndexDouble")]
+public static extern void SetPropertyDouble(JSContext context, JSArray arr, int index, double value, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSArrayPropertyAtIndexInt")]
+public static extern void SetPropertyInt(JSContext context, JSArray arr, int index, int value, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSArrayPropertyAtIndexBool")]
+public static extern void SetPropertyBool(JSContext context, JSArray arr, int index, [MarshalAs(UnmanagedType.I1)]bool value, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSArrayPropertyAtIndexUtf8")]
+public static extern void SetPropertyUtf8(JSContext context, JSArray arr, int index, [In]byte[] value, int length, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSArrayPropertyAtIndexAsDouble")]
+public static extern double GetPropertyAsDouble(JSContext context, JSArray arr, int index, out JSRuntimeError error, out JSScriptException scriptError);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSArrayPropertyAtIndexAsInt")]
+public static extern int GetPropertyAsInt(JSContext context, JSArray arr, int index, out JSRuntimeError error, out JSScriptException scriptError);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSArrayPropertyAtIndexAsBool")]
+[return: MarshalAs(UnmanagedType.I1)]
+public static extern bool GetPropertyAsBool(JSContext context, JSArray arr, int index, out JSRuntimeError error, out JSScriptException scriptError);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSArrayPropertyAtIndexAsString")]
+public static extern int GetPropertyAsString(JSContext context, JSArray arr, int index, [Out]char[] buffer, int bufferLength, out JSRuntimeError error, out JSScriptException scriptError);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSArrayLength")]
-public static extern int Length(JSContext context, JSArray arr);
+public static extern int Length(JSContext context, JSArray arr, out JSRuntimeError error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSArrayAsValue")]
 public static extern JSValue AsValue(JSArray arr);
 // -------------------------------------------------------------------------
+// Map and Set
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSMapSize")]
+public static extern int MapSize(JSContext context, JSObject map, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSMapEntries")]
+public static extern int CopyMapEntries(JSContext context, JSObject map, [Out]JSValue[] keys, [Out]JSValue[] values, int capacity, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSMap")]
+public static extern JSObject CreateMap(JSContext context, [In]JSValue[] keys, [In]JSValue[] values, int count, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSSetSize")]
+public static extern int SetSize(JSContext context, JSObject set, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSSetValues")]
+public static extern int CopySetValues(JSContext context, JSObject set, [Out]JSValue[] values, int capacity, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSSet")]
+public static extern JSObject CreateSet(JSContext context, [In]JSValue[] values, int count, out JSScriptException error);
+// -------------------------------------------------------------------------
 // Function
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CallJSFunctionCreate")]
 public static extern JSValue CallCreate(JSContext context, JSFunction function, JSObject thisObject, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 4)]JSValue[] args, int numArgs, out JSScriptException error);
@@ -197,13 +434,138 @@ public static extern JSValue AsValue(JSFunction fun);
 // -------------------------------------------------------------------------
 // External
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSExternal")]
-public static extern JSExternal CreateExternal(JSContext context, IntPtr value);
+public static extern JSExternal CreateExternal(JSContext context, IntPtr value, out JSRuntimeError error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSExternalValue")]
-public static extern IntPtr GetExternalValue(JSContext context, JSExternal external);
+public static extern IntPtr GetExternalValue(JSContext context, JSExternal external, out JSRuntimeError error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSExternalAsValue")]
 public static extern JSValue AsValue(JSExternal external);
 }
 // -------------------------------------------------------------------------
+// Entries
+public static class Entries
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSObjectEntries")]
+public static extern JSEntries Copy(JSContext context, JSObject obj, [MarshalAs(UnmanagedType.I1)]bool utf8, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSEntries")]
+public static extern void Release(JSContext context, JSEntries entries);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSEntriesCount")]
+public static extern int Count(JSEntries entries);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSEntriesKeysLength")]
+public static extern int KeysLength(JSEntries entries);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSEntriesKeys")]
+public static extern void WriteKeys(JSEntries entries, [Out]char[] keys, [Out]int[] keyEnds);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSEntriesKeys")]
+public static extern void WriteKeysUtf8(JSEntries entries, [Out]byte[] keys, [Out]int[] keyEnds);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSEntriesValues")]
+public static extern void CopyValues(JSEntries entries, [Out]JSValue[] values);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSEntriesCursor")]
+public static extern JSEntriesCursor CreateCursor(JSContext context, JSObject obj, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSEntriesCursor")]
+public static extern void ReleaseCursor(JSContext context, JSEntriesCursor cursor);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyNextJSEntries")]
+public static extern JSEntries CopyNext(JSContext context, JSEntriesCursor cursor, int maxCount, [MarshalAs(UnmanagedType.I1)]bool utf8, out JSScriptException error);
+public static string[] GetKeys(JSEntries entries)
+{
+	var count = Count(entries);
+	var keys = new char[KeysLength(entries)];
+	var keyEnds = new int[count];
+	WriteKeys(entries, keys, keyEnds);
+	var result = new string[count];
+	for (int i = 0, start = 0; i < count; start = keyEnds[i++])
+		result[i] = new string(keys, start, keyEnds[i] - start);
+	return result;
+}
+}
+// -------------------------------------------------------------------------
+// Array cursor
+public static class ArrayCursor
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSArrayCursor")]
+public static extern JSArrayCursor Create(JSContext context, JSArray arr, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSArrayCursor")]
+public static extern void Release(JSContext context, JSArrayCursor cursor, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyNextJSArrayElements")]
+public static extern int CopyNext(JSContext context, JSArrayCursor cursor, [Out]JSType[] types, [Out]double[] numbers, [Out]JSValue[] values, int maxCount, out JSScriptException error);
+}
+// -------------------------------------------------------------------------
+// Property accessors
+public static class PropertyAccessor
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSPropertyAccessor")]
+public static extern JSPropertyAccessor Create(JSContext context, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string name, int length, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSPropertyAccessor")]
+public static extern void Release(JSContext context, JSPropertyAccessor accessor);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSPropertyAccessorValue")]
+public static extern JSValue CopyValue(JSContext context, JSPropertyAccessor accessor, JSObject obj, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSPropertyAccessorValue")]
+public static extern void SetValue(JSContext context, JSPropertyAccessor accessor, JSObject obj, JSValue value, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSPropertyAccessorAsDouble")]
+public static extern double GetAsDouble(JSContext context, JSPropertyAccessor accessor, JSObject obj, out JSRuntimeError error, out JSScriptException scriptError);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSPropertyAccessorAsInt")]
+public static extern int GetAsInt(JSContext context, JSPropertyAccessor accessor, JSObject obj, out JSRuntimeError error, out JSScriptException scriptError);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSPropertyAccessorAsBool")]
+[return: MarshalAs(UnmanagedType.I1)]
+public static extern bool GetAsBool(JSContext context, JSPropertyAccessor accessor, JSObject obj, out JSRuntimeError error, out JSScriptException scriptError);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSPropertyAccessorDouble")]
+public static extern void SetDouble(JSContext context, JSPropertyAccessor accessor, JSObject obj, double value, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSPropertyAccessorInt")]
+public static extern void SetInt(JSContext context, JSPropertyAccessor accessor, JSObject obj, int value, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSPropertyAccessorBool")]
+public static extern void SetBool(JSContext context, JSPropertyAccessor accessor, JSObject obj, [MarshalAs(UnmanagedType.I1)]bool value, out JSScriptException error);
+}
+// -------------------------------------------------------------------------
+// JSON
+public static class Json
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSONParseUtf16Create")]
+public static extern JSValue ParseCreate(JSContext context, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string json, int length, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSONParseUtf8Create")]
+public static extern JSValue ParseUtf8Create(JSContext context, [In]byte[] json, int length, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSONStringifyUtf16")]
+public static extern int Stringify(JSContext context, JSValue value, [Out]char[] buffer, int bufferLength, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSONStringifyUtf8")]
+public static extern int StringifyUtf8(JSContext context, JSValue value, [Out]byte[] buffer, int bufferLength, out JSScriptException error);
+public static string Stringify(JSContext context, JSValue value, out JSScriptException error)
+{
+	var buffer = new char[256];
+	var length = Stringify(context, value, buffer, buffer.Length, out error);
+	if (length < 0)
+		return null;
+	if (length > buffer.Length)
+	{
+		buffer = new char[length];
+		length = Stringify(context, value, buffer, buffer.Length, out error);
+	}
+	return new string(buffer, 0, length);
+}
+}
+// -------------------------------------------------------------------------
+// Binary encoding
+public static class Binary
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="EncodeJSValue")]
+public static extern int Encode(JSContext context, JSValue value, IntPtr buffer, int bufferLength, int maxDepth, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="DecodeJSValueCreate")]
+public static extern JSValue DecodeCreate(JSContext context, IntPtr data, int length, int maxDepth, out JSScriptException error);
+}
+// -------------------------------------------------------------------------
+// Shapes
+public static class Shape
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSShape")]
+public static extern JSShape Create(JSContext context, [In, MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPWStr)]string[] names, [In]JSFieldType[] types, [In]int[] offsets, int fieldCount, int structSize, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSShape")]
+public static extern void Release(JSContext context, JSShape shape);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReadJSStruct")]
+public static extern void Read(JSContext context, JSShape shape, JSObject obj, IntPtr outStruct, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSStructObject")]
+public static extern JSObject CreateObject(JSContext context, JSShape shape, IntPtr data, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReadJSStructArray")]
+public static extern int ReadArray(JSContext context, JSShape shape, JSArray arr, IntPtr outStructs, int capacity, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSStructArray")]
+public static extern JSArray CreateArray(JSContext context, JSShape shape, IntPtr structs, int count, out JSScriptException error);
+}
+// -------------------------------------------------------------------------
 // Exceptions
 public static class ScriptException
 {
@@ -224,4 +586,152 @@ public static extern JSString GetStackTrace(JSScriptException e);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSScriptExceptionSourceLine")]
 public static extern JSString GetSourceLine(JSScriptException e);
 }
+// -------------------------------------------------------------------------
+// Shared ring buffer
+public static class RingBuffer
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSRingBufferByteLength")]
+public static extern int ByteLength(int capacity);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="InitializeJSRingBuffer")]
+public static extern void Initialize(IntPtr memory, int capacity);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSRingBuffer")]
+public static extern int Write(IntPtr memory, int byteLength, IntPtr data, int length);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReadJSRingBuffer")]
+public static extern int Read(IntPtr memory, int byteLength, IntPtr outData, int length);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="InstallJSRingBuffer")]
+public static extern void Install(JSContext context, out JSScriptException error);
+}
+// -------------------------------------------------------------------------
+// Serialization
+public static class Serializer
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SerializeJSValueCreate")]
+public static extern JSSerializedValue SerializeCreate(JSContext context, JSValue value, JSArray transfer, IntPtr hostData, [MarshalAs(UnmanagedType.FunctionPtr)]JSHostObjectWriter hostObjectWriter, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="DeserializeJSValueCreate")]
+public static extern JSValue DeserializeCreate(JSContext context, JSSerializedValue serialized, IntPtr hostData, [MarshalAs(UnmanagedType.FunctionPtr)]JSHostObjectReader hostObjectReader, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSSerializedValue")]
+public static extern JSSerializedValue Create(IntPtr data, int length);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSSerializedValue")]
+public static extern void Retain(JSSerializedValue serialized);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSSerializedValue")]
+public static extern void Release(JSSerializedValue serialized);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSerializedValueData")]
+public static extern IntPtr GetData(JSSerializedValue serialized);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSerializedValueLength")]
+public static extern int GetLength(JSSerializedValue serialized);
+}
+// -------------------------------------------------------------------------
+// WebAssembly
+public static class Wasm
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CompileJSWasmModule")]
+public static extern JSObject Compile(JSContext context, IntPtr bytes, int length, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="InstantiateJSWasmModule")]
+public static extern JSObject Instantiate(JSContext context, JSObject module, JSObject imports, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SerializeJSWasmModuleCreate")]
+public static extern JSSerializedValue SerializeCreate(JSContext context, JSObject module, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="DeserializeJSWasmModule")]
+public static extern JSObject Deserialize(JSContext context, JSSerializedValue serialized, out JSScriptException error);
+}
+// -------------------------------------------------------------------------
+// Worker
+public static class Worker
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSWorker")]
+public static extern JSWorker Create([MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 1)]string fileName, int fileNameLength, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 3)]string code, int codeLength, IntPtr notifierData, [MarshalAs(UnmanagedType.FunctionPtr)]JSWorkerMessageNotifier notifier);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSWorker")]
+public static extern void Release(JSWorker worker);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="PostJSWorkerMessage")]
+public static extern void PostMessage(JSContext context, JSWorker worker, JSValue message, JSArray transfer, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="TryReceiveJSWorkerMessage")]
+[return: MarshalAs(UnmanagedType.I1)]
+public static extern bool TryReceiveMessage(JSContext context, JSWorker worker, out JSValue message, [MarshalAs(UnmanagedType.I1)]out bool isError, out JSScriptException error);
+}
+// -------------------------------------------------------------------------
+// Parallel map
+public static class ParallelPool
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSParallelPool")]
+public static extern JSParallelPool Create(int threadCount, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string code, int codeLength, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 4)]string functionName, int functionNameLength);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSParallelPool")]
+public static extern void Release(JSParallelPool pool);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSParallelMap")]
+public static extern void Map(JSParallelPool pool, IntPtr input, int inputStride, IntPtr output, int outputStride, int count, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSParallelPoolErrorLength")]
+public static extern int ErrorLength(JSParallelPool pool);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSParallelPoolErrorBuffer")]
+public static extern void WriteError(JSParallelPool pool, [Out, MarshalAs(UnmanagedType.LPWStr)]StringBuilder buffer, [MarshalAs(UnmanagedType.I1)]bool nullTerminate);
+public static string GetError(JSParallelPool pool)
+{
+	var sb = new StringBuilder(ErrorLength(pool) + 1);
+	WriteError(pool, sb, true);
+	return sb.ToString();
+}
+}
+// -------------------------------------------------------------------------
+// Stack sampler
+public static class StackSampler
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSStackSampler")]
+public static extern JSStackSampler Create(int capacity, int maxFrames, int maxStackLength);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSStackSampler")]
+public static extern void Release(JSStackSampler sampler);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="AddJSStackSamplerContext")]
+public static extern void AddContext(JSStackSampler sampler, JSContext context, double hz);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RemoveJSStackSamplerContext")]
+public static extern void RemoveContext(JSStackSampler sampler, JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ClearJSStackSampler")]
+public static extern void Clear(JSStackSampler sampler);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSStackSamplerFolded")]
+public static extern int WriteFolded(JSStackSampler sampler, [Out]byte[] buffer, int bufferLength);
+public static string GetFolded(JSStackSampler sampler)
+{
+	var buffer = new byte[4096];
+	var length = WriteFolded(sampler, buffer, buffer.Length);
+	while (length > buffer.Length)
+	{
+		buffer = new byte[length];
+		length = WriteFolded(sampler, buffer, buffer.Length);
+	}
+	return Encoding.UTF8.GetString(buffer, 0, length);
+}
+}
+// -------------------------------------------------------------------------
+// Scheduler
+public static class Scheduler
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSScheduler")]
+public static extern JSScheduler Create(int threadCount);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSScheduler")]
+public static extern void Release(JSScheduler scheduler);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="PostJSSchedulerWork")]
+public static extern void Post(JSScheduler scheduler, JSContext context, JSSchedulerPriority priority, int budgetMilliseconds, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSScheduledWork work);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSchedulerQueueDepth")]
+public static extern int GetQueueDepth(JSScheduler scheduler);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSchedulerContextQueueDepth")]
+public static extern int GetContextQueueDepth(JSScheduler scheduler, JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSchedulerStartedCount")]
+public static extern ulong GetStartedCount(JSScheduler scheduler);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSchedulerTotalWaitTime")]
+public static extern ulong GetTotalWaitTime(JSScheduler scheduler);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSchedulerMaxWaitTime")]
+public static extern ulong GetMaxWaitTime(JSScheduler scheduler);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSchedulerTerminatedCount")]
+public static extern ulong GetTerminatedCount(JSScheduler scheduler);
+}
+// -------------------------------------------------------------------------
+// Executor
+public static class Executor
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSExecutor")]
+public static extern JSExecutor Create(JSContext context, IntPtr notifierData, [MarshalAs(UnmanagedType.FunctionPtr)]JSExecutorNotifier notifier);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSExecutor")]
+public static extern void Release(JSExecutor executor);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SubmitJSExecutorWork")]
+public static extern void SubmitWork(JSExecutor executor, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSScheduledWork work);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SubmitJSExecutorScript")]
+public static extern void SubmitScript(JSExecutor executor, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string fileName, int fileNameLength, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 4)]string code, int codeLength, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSExecutorCompletion completion);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="PumpJSExecutor")]
+public static extern int Pump(JSExecutor executor, int maxJobs);
+}
 }
@@ -34,6 +34,8 @@
 /// 	Array,
 /// 	Function,
 /// 	External,
+/// 	Map,
+/// 	Set,
 /// }
 enum class JSType
 {
@@ -46,6 +48,8 @@ enum class JSType
 	Array,
 	Function,
 	External,
+	Map,
+	Set,
 };
 /// public enum JSRuntimeError
 /// {
@@ -53,6 +57,8 @@ enum class JSType
 /// 	InvalidCast,
 /// 	StringTooLong,
 /// 	TypeError,
+/// 	ScriptError,
+/// 	WrongThread,
 /// }
 enum class JSRuntimeError
 {
@@ -60,6 +66,84 @@ enum class JSRuntimeError
 	InvalidCast,
 	StringTooLong,
 	TypeError,
+	ScriptError,
+	WrongThread,
+};
+/// public enum JSEngineProfile
+/// {
+/// 	Default,
+/// 	LowLatency,
+/// 	Throughput,
+/// 	LowMemory,
+/// }
+enum class JSEngineProfile
+{
+	Default,
+	LowLatency,
+	Throughput,
+	LowMemory,
+};
+/// public enum JSRAILMode
+/// {
+/// 	Response,
+/// 	Animation,
+/// 	Idle,
+/// 	Load,
+/// }
+enum class JSRAILMode
+{
+	Response,
+	Animation,
+	Idle,
+	Load,
+};
+/// public enum JSMemoryPressure
+/// {
+/// 	None,
+/// 	Moderate,
+/// 	Critical,
+/// }
+enum class JSMemoryPressure
+{
+	None,
+	Moderate,
+	Critical,
+};
+/// public enum JSFieldType
+/// {
+/// 	Int8,
+/// 	UInt8,
+/// 	Int16,
+/// 	UInt16,
+/// 	Int32,
+/// 	UInt32,
+/// 	Float,
+/// 	Double,
+/// 	Bool,
+/// }
+enum class JSFieldType
+{
+	Int8,
+	UInt8,
+	Int16,
+	UInt16,
+	Int32,
+	UInt32,
+	Float,
+	Double,
+	Bool,
+};
+/// public enum JSSchedulerPriority
+/// {
+/// 	Low,
+/// 	Normal,
+/// 	High,
+/// }
+enum class JSSchedulerPriority
+{
+	Low,
+	Normal,
+	High,
 };
 /// [StructLayout(LayoutKind.Sequential)]
 /// public struct JSContext
@@ -104,6 +188,78 @@ struct JSFunction;
 /// }
 struct JSExternal;
 /// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSWorker
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSWorker;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSSerializedValue
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSSerializedValue;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSParallelPool
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSParallelPool;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSShape
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSShape;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSSnapshot
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSSnapshot;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSStackSampler
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSStackSampler;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSScheduler
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSScheduler;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSExecutor
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSExecutor;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSEntries
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSEntries;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSEntriesCursor
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSEntriesCursor;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSArrayCursor
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSArrayCursor;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSPropertyAccessor
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSPropertyAccessor;
+/// [StructLayout(LayoutKind.Sequential)]
 /// public struct JSScriptException
 /// {
 /// 	readonly IntPtr _handle;
@@ -121,6 +277,19 @@ typedef void (StdCall *JSExternalFinalizer)(void* external);
 typedef void (StdCall *JSCallbackFinalizer)(void* data);
 /// public delegate void JSDebugMessageHandler(IntPtr data, JSString message);
 typedef void (StdCall *JSDebugMessageHandler)(void* data, JSString* message);
+/// public delegate void JSWorkerMessageNotifier(IntPtr data);
+typedef void (StdCall *JSWorkerMessageNotifier)(void* data);
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public delegate bool JSHostObjectWriter(IntPtr data, JSContext context, JSObject obj, out ulong id);
+typedef bool (StdCall *JSHostObjectWriter)(void* data, JSContext* context, JSObject* object, uint64_t* outId);
+/// public delegate JSObject JSHostObjectReader(IntPtr data, JSContext context, ulong id);
+typedef JSObject* (StdCall *JSHostObjectReader)(void* data, JSContext* context, uint64_t id);
+/// public delegate void JSScheduledWork(IntPtr data, JSContext context, [MarshalAs(UnmanagedType.I1)]bool cancelled);
+typedef void (StdCall *JSScheduledWork)(void* data, JSContext* context, bool cancelled);
+/// public delegate void JSExecutorNotifier(IntPtr data);
+typedef void (StdCall *JSExecutorNotifier)(void* data);
+/// public delegate void JSExecutorCompletion(IntPtr data, JSContext context, JSValue result, JSScriptException error, [MarshalAs(UnmanagedType.I1)]bool cancelled);
+typedef void (StdCall *JSExecutorCompletion)(void* data, JSContext* context, JSValue* result, JSScriptException* error, bool cancelled);
 
 /// // -------------------------------------------------------------------------
 /// // Context
@@ -135,31 +304,188 @@ DllPublic void CDecl ReleaseJSContext(JSContext* context);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSContext")]
 /// public static extern JSContext Create([MarshalAs(UnmanagedType.FunctionPtr)]JSCallbackFinalizer callbackFinalizer, [MarshalAs(UnmanagedType.FunctionPtr)]JSExternalFinalizer externalFinalizer);
 DllPublic JSContext* CDecl CreateJSContext(JSCallbackFinalizer callbackFinalizer, JSExternalFinalizer externalFinalizer);
+///// Locks and enters the isolate once on the calling thread, which must then
+///// make every call into the context. Calls from other threads fail without
+///// touching the context: they return default values and report
+///// JSRuntimeError.WrongThread, or a script exception that only has a
+///// message, which any thread can read. Releases of values, exceptions and the
+///// context itself from other threads are left for the owner, which carries
+///// them out the next time it uses or creates a single-owner context.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSContextSingleOwner")]
+/// public static extern JSContext CreateSingleOwner([MarshalAs(UnmanagedType.FunctionPtr)]JSCallbackFinalizer callbackFinalizer, [MarshalAs(UnmanagedType.FunctionPtr)]JSExternalFinalizer externalFinalizer);
+DllPublic JSContext* CDecl CreateJSContextSingleOwner(JSCallbackFinalizer callbackFinalizer, JSExternalFinalizer externalFinalizer);
+///// The context is created from the snapshot, which it keeps alive.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSContextFromSnapshot")]
+/// public static extern JSContext CreateFromSnapshot([MarshalAs(UnmanagedType.FunctionPtr)]JSCallbackFinalizer callbackFinalizer, [MarshalAs(UnmanagedType.FunctionPtr)]JSExternalFinalizer externalFinalizer, JSSnapshot snapshot);
+DllPublic JSContext* CDecl CreateJSContextFromSnapshot(JSCallbackFinalizer callbackFinalizer, JSExternalFinalizer externalFinalizer, JSSnapshot* snapshot);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSContextEvaluateCreate")]
 /// public static extern JSValue EvaluateCreate(JSContext context, JSString fileName, JSString code, out JSScriptException error);
 DllPublic JSValue* CDecl JSContextEvaluateCreate(JSContext* context, JSString* fileName, JSString* code, JSScriptException** outError);
+///// Evaluates count null-terminated scripts in order under a single entry
+///// into the context, discarding their results. outErrors receives one entry
+///// per script, null unless that script threw. Stops after the first error
+///// unless continueOnError is set, leaving the rest of the entries null.
+///// Returns the index of the first script that threw, or -1. Returns -2 without
+///// evaluating anything or touching outErrors if count is negative.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSContextEvaluateBatch")]
+/// public static extern int EvaluateBatch(JSContext context, [In, MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPWStr)]string[] fileNames, [In, MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPWStr)]string[] codes, int count, [MarshalAs(UnmanagedType.I1)]bool continueOnError, [Out]JSScriptException[] errors);
+DllPublic int CDecl JSContextEvaluateBatch(JSContext* context, const uint16_t* const* fileNames, const uint16_t* const* codes, int count, bool continueOnError, JSScriptException** outErrors);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSContextCopyGlobalObject")]
-/// public static extern JSObject CopyGlobalObject(JSContext context);
-DllPublic JSObject* CDecl JSContextCopyGlobalObject(JSContext* context);
+/// public static extern JSObject CopyGlobalObject(JSContext context, out JSRuntimeError error);
+DllPublic JSObject* CDecl JSContextCopyGlobalObject(JSContext* context, JSRuntimeError* outError);
+///// Sets the V8 flags used when the engine is first initialized, which
+///// happens when the first context is created. The profile's flags are
+///// applied first, so the raw flags (which may be null) can override them.
+///// LowLatency keeps the young generation small to keep scavenges short,
+///// Throughput makes it large and starts contexts in the Load RAIL mode, and
+///// LowMemory optimizes for size. Returns false if the engine has already
+///// been initialized.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ConfigureJSEngine")]
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public static extern bool ConfigureEngine(JSEngineProfile profile, [MarshalAs(UnmanagedType.LPStr)]string flags);
+DllPublic bool CDecl ConfigureJSEngine(JSEngineProfile profile, const char* flags);
+///// Tells V8 what the context is currently doing, e.g. Load during startup
+///// and Animation during interaction. Contexts start in Animation, unless
+///// the engine profile says otherwise.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSContextRAILMode")]
+/// public static extern void SetRAILMode(JSContext context, JSRAILMode mode, out JSRuntimeError error);
+DllPublic void CDecl SetJSContextRAILMode(JSContext* context, JSRAILMode mode, JSRuntimeError* outError);
+///// Backgrounded contexts are tuned for memory rather than speed: V8 is told
+///// the isolate is in the background and that memory is moderately tight,
+///// and process-wide memory pressure hits them one level harder.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSContextInBackground")]
+/// public static extern void SetInBackground(JSContext context, [MarshalAs(UnmanagedType.I1)]bool inBackground, out JSRuntimeError error);
+DllPublic void CDecl SetJSContextInBackground(JSContext* context, bool inBackground, JSRuntimeError* outError);
+///// May be called from any thread, even while the context is running script.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="NotifyJSContextMemoryPressure")]
+/// public static extern void NotifyMemoryPressure(JSContext context, JSMemoryPressure level);
+DllPublic void CDecl NotifyJSContextMemoryPressure(JSContext* context, JSMemoryPressure level);
+///// Forwards the system's memory pressure to every live context, including
+///// those owned by workers and parallel pools. May be called from any thread.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="NotifyJSMemoryPressure")]
+/// public static extern void NotifyMemoryPressure(JSMemoryPressure level);
+DllPublic void CDecl NotifyJSMemoryPressure(JSMemoryPressure level);
+///// CPU time accounting, off by default. While on, the CPU time of the
+///// thread using the context is counted, from the outermost entry into the
+///// context until the exit, and so is the part of that spent in host
+///// callbacks; the rest is the time spent in JS and the engine. Times are in
+///// nanoseconds, and may be read from any thread.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSContextCpuAccounting")]
+/// public static extern void SetCpuAccounting(JSContext context, [MarshalAs(UnmanagedType.I1)]bool enabled);
+DllPublic void CDecl SetJSContextCpuAccounting(JSContext* context, bool enabled);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSContextCpuTime")]
+/// public static extern ulong GetCpuTime(JSContext context);
+DllPublic uint64_t CDecl GetJSContextCpuTime(JSContext* context);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSContextHostCpuTime")]
+/// public static extern ulong GetHostCpuTime(JSContext context);
+DllPublic uint64_t CDecl GetJSContextHostCpuTime(JSContext* context);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ResetJSContextCpuTime")]
+/// public static extern void ResetCpuTime(JSContext context);
+DllPublic void CDecl ResetJSContextCpuTime(JSContext* context);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetV8Version")]
 /// public static extern IntPtr GetV8VersionPtr();
 /// public static string GetV8Version() { return Marshal.PtrToStringAnsi(GetV8VersionPtr()); }
 DllPublic const char* CDecl GetV8Version();
 /// }
 
+/// // -------------------------------------------------------------------------
+/// // Snapshots
+///// Startup snapshots of the engine's heap, optionally with a script run in
+///// the context first. A warmed-up snapshot also contains the code compiled
+///// while running a warm-up script against the cold one, so that the first
+///// runs of that code don't have to compile it lazily. Requires a V8 built
+///// with snapshot support.
+/// public static class Snapshot
+/// {
+///// Returns null if embeddedSource (which may be null) throws.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSSnapshot")]
+/// public static extern JSSnapshot Create([MarshalAs(UnmanagedType.LPStr)]string embeddedSource);
+DllPublic JSSnapshot* CDecl CreateJSSnapshot(const char* embeddedSource);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WarmUpJSSnapshot")]
+/// public static extern JSSnapshot WarmUp(JSSnapshot coldSnapshot, [MarshalAs(UnmanagedType.LPStr)]string warmupSource);
+DllPublic JSSnapshot* CDecl WarmUpJSSnapshot(JSSnapshot* coldSnapshot, const char* warmupSource);
+///// Copies a snapshot previously written to disk.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSSnapshotFromData")]
+/// public static extern JSSnapshot CreateFromData([In]byte[] data, int length);
+DllPublic JSSnapshot* CDecl CreateJSSnapshotFromData(const void* data, int length);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSSnapshot")]
+/// public static extern void Retain(JSSnapshot snapshot);
+DllPublic void CDecl RetainJSSnapshot(JSSnapshot* snapshot);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSSnapshot")]
+/// public static extern void Release(JSSnapshot snapshot);
+DllPublic void CDecl ReleaseJSSnapshot(JSSnapshot* snapshot);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSnapshotData")]
+/// public static extern IntPtr GetData(JSSnapshot snapshot);
+DllPublic const void* CDecl GetJSSnapshotData(JSSnapshot* snapshot);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSnapshotLength")]
+/// public static extern int GetLength(JSSnapshot snapshot);
+DllPublic int CDecl GetJSSnapshotLength(JSSnapshot* snapshot);
+///// Tool mode for build steps: creates a snapshot from embeddedSource, warms
+///// it up with warmupSource and writes it to path. Returns false if either
+///// script throws or the file can't be written.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSWarmSnapshotFile")]
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public static extern bool WriteWarmFile([MarshalAs(UnmanagedType.LPStr)]string embeddedSource, [MarshalAs(UnmanagedType.LPStr)]string warmupSource, [MarshalAs(UnmanagedType.LPStr)]string path);
+DllPublic bool CDecl WriteJSWarmSnapshotFile(const char* embeddedSource, const char* warmupSource, const char* path);
+///// Snapshots of contexts with the host API installed. Host functions and
+///// objects made with CreateJSCallback and CreateJSExternal point at host
+///// memory and can't be put in a snapshot; the ones below refer to the host
+///// by an id instead, which each context binds to the actual callback or
+///// value. Bind ids both when building the snapshot context (to run setup
+///// code) and again in every context restored from the snapshot. Bound data
+///// and values are passed to the context's finalizers when it is released or
+///// they are rebound.
+/////
+///// A snapshot context must be used only on the thread that created it. Once
+///// CreateJSSnapshotFromContext has been called it can only be released, and
+///// any values from it should be released before then.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSSnapshotContext")]
+/// public static extern JSContext CreateContext([MarshalAs(UnmanagedType.FunctionPtr)]JSCallbackFinalizer callbackFinalizer, [MarshalAs(UnmanagedType.FunctionPtr)]JSExternalFinalizer externalFinalizer);
+DllPublic JSContext* CDecl CreateJSSnapshotContext(JSCallbackFinalizer callbackFinalizer, JSExternalFinalizer externalFinalizer);
+///// Returns null if context wasn't created with CreateJSSnapshotContext, or
+///// while the host holds anything from it: values, exceptions, cursors,
+///// accessors and shapes that haven't been released, and callbacks and
+///// externals that script can still reach. The context can then still be
+///// used, and the snapshot taken once they are gone.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSSnapshotFromContext")]
+/// public static extern JSSnapshot CreateFromContext(JSContext context, [MarshalAs(UnmanagedType.I1)]bool keepCompiledCode, out JSRuntimeError error);
+DllPublic JSSnapshot* CDecl CreateJSSnapshotFromContext(JSContext* context, bool keepCompiledCode, JSRuntimeError* outError);
+///// Calling the function before id is bound throws an Error.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSHostFunction")]
+/// public static extern JSFunction CreateHostFunction(JSContext context, uint id, out JSScriptException error);
+DllPublic JSFunction* CDecl CreateJSHostFunction(JSContext* context, uint32_t id, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="BindJSHostFunction")]
+/// public static extern void BindHostFunction(JSContext context, uint id, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSCallback callback, out JSRuntimeError error);
+DllPublic void CDecl BindJSHostFunction(JSContext* context, uint32_t id, void* data, JSCallback callback, JSRuntimeError* outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSHostObject")]
+/// public static extern JSObject CreateHostObject(JSContext context, uint id, out JSScriptException error);
+DllPublic JSObject* CDecl CreateJSHostObject(JSContext* context, uint32_t id, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="BindJSHostObject")]
+/// public static extern void BindHostObject(JSContext context, uint id, IntPtr value, out JSRuntimeError error);
+DllPublic void CDecl BindJSHostObject(JSContext* context, uint32_t id, void* value, JSRuntimeError* outError);
+///// Sets error to TypeError if obj isn't a host object.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSHostObjectId")]
+/// public static extern uint GetHostObjectId(JSContext context, JSObject obj, out JSRuntimeError error);
+DllPublic uint32_t CDecl GetJSHostObjectId(JSContext* context, JSObject* obj, JSRuntimeError* outError);
+///// Returns null if the object's id is not bound.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSHostObjectValue")]
+/// public static extern IntPtr GetHostObjectValue(JSContext context, JSObject obj, out JSRuntimeError error);
+DllPublic void* CDecl GetJSHostObjectValue(JSContext* context, JSObject* obj, JSRuntimeError* outError);
+/// }
+
 /// // -------------------------------------------------------------------------
 /// // Debug
 /// public static class Debug
 /// {
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSDebugMessageHandler")]
-/// public static extern void SetMessageHandler(JSContext context, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSDebugMessageHandler messageHandler);
-DllPublic void CDecl SetJSDebugMessageHandler(JSContext* context, void* data, JSDebugMessageHandler messageHandler);
+/// public static extern void SetMessageHandler(JSContext context, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSDebugMessageHandler messageHandler, out JSRuntimeError error);
+DllPublic void CDecl SetJSDebugMessageHandler(JSContext* context, void* data, JSDebugMessageHandler messageHandler, JSRuntimeError* outError);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SendJSDebugCommand")]
 /// public static extern void SendCommand(JSContext context, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string command, int length);
 DllPublic void CDecl SendJSDebugCommand(JSContext* context, const uint16_t* command, int length);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ProcessJSDebugMessages")]
-/// public static extern void ProcessMessages(JSContext context);
-DllPublic void CDecl ProcessJSDebugMessages(JSContext* context);
+/// public static extern void ProcessMessages(JSContext context, out JSRuntimeError error);
+DllPublic void CDecl ProcessJSDebugMessages(JSContext* context, JSRuntimeError* outError);
 /// }
 
 /// // -------------------------------------------------------------------------
@@ -188,6 +514,8 @@ DllPublic JSString* CDecl JSValueAsString(JSValue* value, JSRuntimeError* outErr
 /// [return: MarshalAs(UnmanagedType.I1)]
 /// public static extern bool AsBool(JSValue value, out JSRuntimeError error);
 DllPublic bool CDecl JSValueAsBool(JSValue* value, JSRuntimeError* outError);
+///// Maps and Sets are objects too, and can be used wherever a JSObject is
+///// expected.
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSValueAsObject")]
 /// public static extern JSObject AsObject(JSValue value, out JSRuntimeError error);
 DllPublic JSObject* CDecl JSValueAsObject(JSValue* value, JSRuntimeError* outError);
@@ -202,8 +530,8 @@ DllPublic JSFunction* CDecl JSValueAsFunction(JSValue* value, JSRuntimeError* ou
 DllPublic JSExternal* CDecl JSValueAsExternal(JSValue* value, JSRuntimeError* outError);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSValueStrictEquals")]
 /// [return: MarshalAs(UnmanagedType.I1)]
-/// public static extern bool StrictEquals(JSContext context, JSValue obj1, JSValue obj2);
-DllPublic bool CDecl JSValueStrictEquals(JSContext* context, JSValue* obj1, JSValue* obj2);
+/// public static extern bool StrictEquals(JSContext context, JSValue obj1, JSValue obj2, out JSRuntimeError error);
+DllPublic bool CDecl JSValueStrictEquals(JSContext* context, JSValue* obj1, JSValue* obj2, JSRuntimeError* outError);
 
 /// // --------------------------------------------------------------------------
 /// // Primitives
@@ -221,8 +549,13 @@ DllPublic JSValue* CDecl CreateJSDouble(double value);
 DllPublic JSValue* CDecl CreateJSBool(bool value);
 ///// Not memory managed; add an External property if data needs to be retained
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateExternalJSArrayBuffer")]
-/// public static extern JSObject CreateExternalArrayBuffer(JSContext context, IntPtr data, int byteLength);
-DllPublic JSObject* CDecl CreateExternalJSArrayBuffer(JSContext* context, void* data, int byteLength);
+/// public static extern JSObject CreateExternalArrayBuffer(JSContext context, IntPtr data, int byteLength, out JSRuntimeError error);
+DllPublic JSObject* CDecl CreateExternalJSArrayBuffer(JSContext* context, void* data, int byteLength, JSRuntimeError* outError);
+///// Not memory managed either. Scripts can access the memory with Atomics
+///// while the host reads and writes it from other threads.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateExternalJSSharedArrayBuffer")]
+/// public static extern JSObject CreateExternalSharedArrayBuffer(JSContext context, IntPtr data, int byteLength, out JSRuntimeError error);
+DllPublic JSObject* CDecl CreateExternalJSSharedArrayBuffer(JSContext* context, void* data, int byteLength, JSRuntimeError* outError);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSCallback")]
 /// public static extern JSFunction CreateCallback(JSContext context, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSCallback callback, out JSScriptException error);
 DllPublic JSFunction* CDecl CreateJSCallback(JSContext* context, void* data, JSCallback callback, JSScriptException** outError);
@@ -233,15 +566,20 @@ DllPublic JSFunction* CDecl CreateJSCallback(JSContext* context, void* data, JSC
 /// public static extern JSString CreateString(JSContext context, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string buffer, int length, out JSRuntimeError error);
 DllPublic JSString* CDecl CreateJSString(JSContext* context, const uint16_t* buffer, int length, JSRuntimeError* outError);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSStringLength")]
-/// public static extern int Length(JSContext context, JSString str);
-DllPublic int CDecl JSStringLength(JSContext* context, JSString* string);
+/// public static extern int Length(JSContext context, JSString str, out JSRuntimeError error);
+DllPublic int CDecl JSStringLength(JSContext* context, JSString* string, JSRuntimeError* outError);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSStringBuffer")]
-/// public static extern void Write(JSContext context, JSString str, [Out, MarshalAs(UnmanagedType.LPWStr)]StringBuilder buffer, [MarshalAs(UnmanagedType.I1)]bool nullTerminate);
-DllPublic void CDecl WriteJSStringBuffer(JSContext* context, JSString* string, uint16_t* outBuffer, bool nullTerminate);
+/// public static extern void Write(JSContext context, JSString str, [Out, MarshalAs(UnmanagedType.LPWStr)]StringBuilder buffer, [MarshalAs(UnmanagedType.I1)]bool nullTerminate, out JSRuntimeError error);
+DllPublic void CDecl WriteJSStringBuffer(JSContext* context, JSString* string, uint16_t* outBuffer, bool nullTerminate, JSRuntimeError* outError);
+///// Returns null for a call from the wrong thread.
 /// public static string ToString(JSContext context, JSString str)
 /// {
-/// 	var sb = new StringBuilder(Length(context, str) + 1);
-/// 	Write(context, str, sb, true);
+/// 	JSRuntimeError error;
+/// 	var length = Length(context, str, out error);
+/// 	if (error != JSRuntimeError.NoError)
+/// 		return null;
+/// 	var sb = new StringBuilder(length + 1);
+/// 	Write(context, str, sb, true, out error);
 /// 	return sb.ToString();
 /// }
 
@@ -257,6 +595,19 @@ DllPublic JSValue* CDecl CopyJSObjectProperty(JSContext* context, JSObject* obj,
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSObjectProperty")]
 /// public static extern void SetProperty(JSContext context, JSObject obj, JSString key, JSValue value, out JSScriptException error);
 DllPublic void CDecl SetJSObjectProperty(JSContext* context, JSObject* obj, JSString* key, JSValue* value, JSScriptException** outError);
+///// The typed setters write primitives without creating a JSValue first.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSObjectPropertyDouble")]
+/// public static extern void SetPropertyDouble(JSContext context, JSObject obj, JSString key, double value, out JSScriptException error);
+DllPublic void CDecl SetJSObjectPropertyDouble(JSContext* context, JSObject* obj, JSString* key, double value, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSObjectPropertyInt")]
+/// public static extern void SetPropertyInt(JSContext context, JSObject obj, JSString key, int value, out JSScriptException error);
+DllPublic void CDecl SetJSObjectPropertyInt(JSContext* context, JSObject* obj, JSString* key, int value, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSObjectPropertyBool")]
+/// public static extern void SetPropertyBool(JSContext context, JSObject obj, JSString key, [MarshalAs(UnmanagedType.I1)]bool value, out JSScriptException error);
+DllPublic void CDecl SetJSObjectPropertyBool(JSContext* context, JSObject* obj, JSString* key, bool value, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSObjectPropertyUtf8")]
+/// public static extern void SetPropertyUtf8(JSContext context, JSObject obj, JSString key, [In]byte[] value, int length, out JSScriptException error);
+DllPublic void CDecl SetJSObjectPropertyUtf8(JSContext* context, JSObject* obj, JSString* key, const char* value, int length, JSScriptException** outError);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSObjectOwnPropertyNames")]
 /// public static extern JSArray CopyOwnPropertyNames(JSContext context, JSObject obj, out JSScriptException error);
 DllPublic JSArray* CDecl CopyJSObjectOwnPropertyNames(JSContext* context, JSObject* obj, JSScriptException** outError);
@@ -267,6 +618,35 @@ DllPublic bool CDecl JSObjectHasProperty(JSContext* context, JSObject* obj, JSSt
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectArrayBufferData")]
 /// public static extern IntPtr GetArrayBufferData(JSContext context, JSObject obj, out JSRuntimeError outError);
 DllPublic void* CDecl GetJSObjectArrayBufferData(JSContext* context, JSObject* obj, JSRuntimeError* outError);
+///// The typed getters don't wrap the property value. If it has a different
+///// type, error is set to InvalidCast and the result is 0 (or false). Int only
+///// accepts int32 values, while Double accepts any number. AsString returns
+///// the length of the string, but only writes it if it fits in bufferLength
+///// (it is not null terminated).
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectPropertyAsDouble")]
+/// public static extern double GetPropertyAsDouble(JSContext context, JSObject obj, JSString key, out JSRuntimeError error, out JSScriptException scriptError);
+DllPublic double CDecl GetJSObjectPropertyAsDouble(JSContext* context, JSObject* obj, JSString* key, JSRuntimeError* outError, JSScriptException** outScriptError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectPropertyAsInt")]
+/// public static extern int GetPropertyAsInt(JSContext context, JSObject obj, JSString key, out JSRuntimeError error, out JSScriptException scriptError);
+DllPublic int CDecl GetJSObjectPropertyAsInt(JSContext* context, JSObject* obj, JSString* key, JSRuntimeError* outError, JSScriptException** outScriptError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectPropertyAsBool")]
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public static extern bool GetPropertyAsBool(JSContext context, JSObject obj, JSString key, out JSRuntimeError error, out JSScriptException scriptError);
+DllPublic bool CDecl GetJSObjectPropertyAsBool(JSContext* context, JSObject* obj, JSString* key, JSRuntimeError* outError, JSScriptException** outScriptError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectPropertyAsString")]
+/// public static extern int GetPropertyAsString(JSContext context, JSObject obj, JSString key, [Out]char[] buffer, int bufferLength, out JSRuntimeError error, out JSScriptException scriptError);
+DllPublic int CDecl GetJSObjectPropertyAsString(JSContext* context, JSObject* obj, JSString* key, uint16_t* outBuffer, int bufferLength, JSRuntimeError* outError, JSScriptException** outScriptError);
+/// public static string GetPropertyAsString(JSContext context, JSObject obj, JSString key, out JSRuntimeError error, out JSScriptException scriptError)
+/// {
+/// 	var buffer = new char[64];
+/// 	var length = GetPropertyAsString(context, obj, key, buffer, buffer.Length, out error, out scriptError);
+/// 	if (length > buffer.Length)
+/// 	{
+/// 		buffer = new char[length];
+/// 		length = GetPropertyAsString(context, obj, key, buffer, buffer.Length, out error, out scriptError);
+/// 	}
+/// 	return new string(buffer, 0, length);
+/// }
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSObjectAsValue")]
 /// public static extern JSValue AsValue(JSObject obj);
 DllPublic JSValue* CDecl JSObjectAsValue(JSObject* obj);
@@ -279,13 +659,66 @@ DllPublic JSValue* CDecl CopyJSArrayPropertyAtIndex(JSContext* context, JSArray*
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSArrayPropertyAtIndex")]
 /// public static extern void SetProperty(JSContext context, JSArray arr, int index, JSValue value, out JSScriptException error);
 DllPublic void CDecl SetJSArrayPropertyAtIndex(JSContext* context, JSArray* arr, int index, JSValue* value, JSScriptException** outError);
+///// Indexed versions of the typed object property setters and getters.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSArrayPropertyAtIndexDouble")]
+/// public static extern void SetPropertyDouble(JSContext context, JSArray arr, int index, double value, out JSScriptException error);
+DllPublic void CDecl SetJSArrayPropertyAtIndexDouble(JSContext* context, JSArray* arr, int index, double value, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSArrayPropertyAtIndexInt")]
+/// public static extern void SetPropertyInt(JSContext context, JSArray arr, int index, int value, out JSScriptException error);
+DllPublic void CDecl SetJSArrayPropertyAtIndexInt(JSContext* context, JSArray* arr, int index, int value, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSArrayPropertyAtIndexBool")]
+/// public static extern void SetPropertyBool(JSContext context, JSArray arr, int index, [MarshalAs(UnmanagedType.I1)]bool value, out JSScriptException error);
+DllPublic void CDecl SetJSArrayPropertyAtIndexBool(JSContext* context, JSArray* arr, int index, bool value, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSArrayPropertyAtIndexUtf8")]
+/// public static extern void SetPropertyUtf8(JSContext context, JSArray arr, int index, [In]byte[] value, int length, out JSScriptException error);
+DllPublic void CDecl SetJSArrayPropertyAtIndexUtf8(JSContext* context, JSArray* arr, int index, const char* value, int length, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSArrayPropertyAtIndexAsDouble")]
+/// public static extern double GetPropertyAsDouble(JSContext context, JSArray arr, int index, out JSRuntimeError error, out JSScriptException scriptError);
+DllPublic double CDecl GetJSArrayPropertyAtIndexAsDouble(JSContext* context, JSArray* arr, int index, JSRuntimeError* outError, JSScriptException** outScriptError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSArrayPropertyAtIndexAsInt")]
+/// public static extern int GetPropertyAsInt(JSContext context, JSArray arr, int index, out JSRuntimeError error, out JSScriptException scriptError);
+DllPublic int CDecl GetJSArrayPropertyAtIndexAsInt(JSContext* context, JSArray* arr, int index, JSRuntimeError* outError, JSScriptException** outScriptError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSArrayPropertyAtIndexAsBool")]
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public static extern bool GetPropertyAsBool(JSContext context, JSArray arr, int index, out JSRuntimeError error, out JSScriptException scriptError);
+DllPublic bool CDecl GetJSArrayPropertyAtIndexAsBool(JSContext* context, JSArray* arr, int index, JSRuntimeError* outError, JSScriptException** outScriptError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSArrayPropertyAtIndexAsString")]
+/// public static extern int GetPropertyAsString(JSContext context, JSArray arr, int index, [Out]char[] buffer, int bufferLength, out JSRuntimeError error, out JSScriptException scriptError);
+DllPublic int CDecl GetJSArrayPropertyAtIndexAsString(JSContext* context, JSArray* arr, int index, uint16_t* outBuffer, int bufferLength, JSRuntimeError* outError, JSScriptException** outScriptError);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSArrayLength")]
-/// public static extern int Length(JSContext context, JSArray arr);
-DllPublic int CDecl JSArrayLength(JSContext* context, JSArray* arr);
+/// public static extern int Length(JSContext context, JSArray arr, out JSRuntimeError error);
+DllPublic int CDecl JSArrayLength(JSContext* context, JSArray* arr, JSRuntimeError* outError);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSArrayAsValue")]
 /// public static extern JSValue AsValue(JSArray arr);
 DllPublic JSValue* CDecl JSArrayAsValue(JSArray* arr);
 
+/// // -------------------------------------------------------------------------
+/// // Map and Set
+///// The Copy functions write up to capacity entries, each a new reference, and
+///// return the size of the collection. They fail with a TypeError when given
+///// an object that is not a Map (or Set). If copying fails part way, the
+///// references copied so far are released and the outputs are left null. A
+///// negative capacity, or a negative count for the Create functions, fails
+///// with a RangeError.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSMapSize")]
+/// public static extern int MapSize(JSContext context, JSObject map, out JSRuntimeError error);
+DllPublic int CDecl JSMapSize(JSContext* context, JSObject* map, JSRuntimeError* outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSMapEntries")]
+/// public static extern int CopyMapEntries(JSContext context, JSObject map, [Out]JSValue[] keys, [Out]JSValue[] values, int capacity, out JSScriptException error);
+DllPublic int CDecl CopyJSMapEntries(JSContext* context, JSObject* map, JSValue** outKeys, JSValue** outValues, int capacity, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSMap")]
+/// public static extern JSObject CreateMap(JSContext context, [In]JSValue[] keys, [In]JSValue[] values, int count, out JSScriptException error);
+DllPublic JSObject* CDecl CreateJSMap(JSContext* context, JSValue* const* keys, JSValue* const* values, int count, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSSetSize")]
+/// public static extern int SetSize(JSContext context, JSObject set, out JSRuntimeError error);
+DllPublic int CDecl JSSetSize(JSContext* context, JSObject* set, JSRuntimeError* outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSSetValues")]
+/// public static extern int CopySetValues(JSContext context, JSObject set, [Out]JSValue[] values, int capacity, out JSScriptException error);
+DllPublic int CDecl CopyJSSetValues(JSContext* context, JSObject* set, JSValue** outValues, int capacity, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSSet")]
+/// public static extern JSObject CreateSet(JSContext context, [In]JSValue[] values, int count, out JSScriptException error);
+DllPublic JSObject* CDecl CreateJSSet(JSContext* context, JSValue* const* values, int count, JSScriptException** outError);
+
 /// // -------------------------------------------------------------------------
 /// // Function
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CallJSFunctionCreate")]
@@ -301,16 +734,232 @@ DllPublic JSValue* CDecl JSFunctionAsValue(JSFunction* fun);
 /// // -------------------------------------------------------------------------
 /// // External
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSExternal")]
-/// public static extern JSExternal CreateExternal(JSContext context, IntPtr value);
-DllPublic JSExternal* CDecl CreateJSExternal(JSContext* context, void* value);
+/// public static extern JSExternal CreateExternal(JSContext context, IntPtr value, out JSRuntimeError error);
+DllPublic JSExternal* CDecl CreateJSExternal(JSContext* context, void* value, JSRuntimeError* outError);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSExternalValue")]
-/// public static extern IntPtr GetExternalValue(JSContext context, JSExternal external);
-DllPublic void* CDecl GetJSExternalValue(JSContext* context, JSExternal* external);
+/// public static extern IntPtr GetExternalValue(JSContext context, JSExternal external, out JSRuntimeError error);
+DllPublic void* CDecl GetJSExternalValue(JSContext* context, JSExternal* external, JSRuntimeError* outError);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSExternalAsValue")]
 /// public static extern JSValue AsValue(JSExternal external);
 DllPublic JSValue* CDecl JSExternalAsValue(JSExternal* external);
 /// }
 
+/// // -------------------------------------------------------------------------
+/// // Entries
+///// The own enumerable properties of an object, read in one call. Keys are
+///// converted to strings and stored back to back in one UTF-16 or UTF-8
+///// buffer, with the end offset of each key (in code units or bytes) in
+///// keyEnds.
+/// public static class Entries
+/// {
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSObjectEntries")]
+/// public static extern JSEntries Copy(JSContext context, JSObject obj, [MarshalAs(UnmanagedType.I1)]bool utf8, out JSScriptException error);
+DllPublic JSEntries* CDecl CopyJSObjectEntries(JSContext* context, JSObject* obj, bool utf8, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSEntries")]
+/// public static extern void Release(JSContext context, JSEntries entries);
+DllPublic void CDecl ReleaseJSEntries(JSContext* context, JSEntries* entries);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSEntriesCount")]
+/// public static extern int Count(JSEntries entries);
+DllPublic int CDecl JSEntriesCount(JSEntries* entries);
+///// The length of the key buffer, in code units or bytes.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSEntriesKeysLength")]
+/// public static extern int KeysLength(JSEntries entries);
+DllPublic int CDecl JSEntriesKeysLength(JSEntries* entries);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSEntriesKeys")]
+/// public static extern void WriteKeys(JSEntries entries, [Out]char[] keys, [Out]int[] keyEnds);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSEntriesKeys")]
+/// public static extern void WriteKeysUtf8(JSEntries entries, [Out]byte[] keys, [Out]int[] keyEnds);
+DllPublic void CDecl WriteJSEntriesKeys(JSEntries* entries, void* outKeys, int* outKeyEnds);
+///// Every value written to values is a new reference.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSEntriesValues")]
+/// public static extern void CopyValues(JSEntries entries, [Out]JSValue[] values);
+DllPublic void CDecl CopyJSEntriesValues(JSEntries* entries, JSValue** outValues);
+///// A cursor takes the keys of obj when it is created, and then reads their
+///// values maxCount at a time, for objects too large to copy in one go. Keys
+///// deleted in the meantime are skipped.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSEntriesCursor")]
+/// public static extern JSEntriesCursor CreateCursor(JSContext context, JSObject obj, out JSScriptException error);
+DllPublic JSEntriesCursor* CDecl CreateJSEntriesCursor(JSContext* context, JSObject* obj, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSEntriesCursor")]
+/// public static extern void ReleaseCursor(JSContext context, JSEntriesCursor cursor);
+DllPublic void CDecl ReleaseJSEntriesCursor(JSContext* context, JSEntriesCursor* cursor);
+///// Returns null when the cursor is exhausted.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyNextJSEntries")]
+/// public static extern JSEntries CopyNext(JSContext context, JSEntriesCursor cursor, int maxCount, [MarshalAs(UnmanagedType.I1)]bool utf8, out JSScriptException error);
+DllPublic JSEntries* CDecl CopyNextJSEntries(JSContext* context, JSEntriesCursor* cursor, int maxCount, bool utf8, JSScriptException** outError);
+/// public static string[] GetKeys(JSEntries entries)
+/// {
+/// 	var count = Count(entries);
+/// 	var keys = new char[KeysLength(entries)];
+/// 	var keyEnds = new int[count];
+/// 	WriteKeys(entries, keys, keyEnds);
+/// 	var result = new string[count];
+/// 	for (int i = 0, start = 0; i < count; start = keyEnds[i++])
+/// 		result[i] = new string(keys, start, keyEnds[i] - start);
+/// 	return result;
+/// }
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Array cursor
+///// A cursor keeps the context's isolate locked from creation until it is
+///// released, which must happen on the thread that created it. Other threads
+///// using the context block in the meantime. CopyNext on another thread fails
+///// with an exception, which has no message unless the context is single-owner.
+///// Release on another thread reports WrongThread and leaves the cursor alone,
+///// except for single-owner contexts, whose owner releases it later.
+/// public static class ArrayCursor
+/// {
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSArrayCursor")]
+/// public static extern JSArrayCursor Create(JSContext context, JSArray arr, out JSRuntimeError error);
+DllPublic JSArrayCursor* CDecl CreateJSArrayCursor(JSContext* context, JSArray* arr, JSRuntimeError* outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSArrayCursor")]
+/// public static extern void Release(JSContext context, JSArrayCursor cursor, out JSRuntimeError error);
+DllPublic void CDecl ReleaseJSArrayCursor(JSContext* context, JSArrayCursor* cursor, JSRuntimeError* outError);
+///// Reads up to maxCount elements and returns how many were read, 0 at the
+///// end of the array. Ints, doubles and bools (as 0 or 1) are written to
+///// numbers, and their values entry is null; strings, objects, arrays and
+///// functions get a new reference in values.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyNextJSArrayElements")]
+/// public static extern int CopyNext(JSContext context, JSArrayCursor cursor, [Out]JSType[] types, [Out]double[] numbers, [Out]JSValue[] values, int maxCount, out JSScriptException error);
+DllPublic int CDecl CopyNextJSArrayElements(JSContext* context, JSArrayCursor* cursor, JSType* outTypes, double* outNumbers, JSValue** outValues, int maxCount, JSScriptException** outError);
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Property accessors
+///// An accessor binds a property name once, as an internalized string, so
+///// that getting and setting it on many objects skips creating and looking up
+///// the key on every call. The typed getters and setters work like the ones
+///// taking a JSString key.
+/// public static class PropertyAccessor
+/// {
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSPropertyAccessor")]
+/// public static extern JSPropertyAccessor Create(JSContext context, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string name, int length, out JSRuntimeError error);
+DllPublic JSPropertyAccessor* CDecl CreateJSPropertyAccessor(JSContext* context, const uint16_t* name, int length, JSRuntimeError* outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSPropertyAccessor")]
+/// public static extern void Release(JSContext context, JSPropertyAccessor accessor);
+DllPublic void CDecl ReleaseJSPropertyAccessor(JSContext* context, JSPropertyAccessor* accessor);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSPropertyAccessorValue")]
+/// public static extern JSValue CopyValue(JSContext context, JSPropertyAccessor accessor, JSObject obj, out JSScriptException error);
+DllPublic JSValue* CDecl CopyJSPropertyAccessorValue(JSContext* context, JSPropertyAccessor* accessor, JSObject* obj, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSPropertyAccessorValue")]
+/// public static extern void SetValue(JSContext context, JSPropertyAccessor accessor, JSObject obj, JSValue value, out JSScriptException error);
+DllPublic void CDecl SetJSPropertyAccessorValue(JSContext* context, JSPropertyAccessor* accessor, JSObject* obj, JSValue* value, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSPropertyAccessorAsDouble")]
+/// public static extern double GetAsDouble(JSContext context, JSPropertyAccessor accessor, JSObject obj, out JSRuntimeError error, out JSScriptException scriptError);
+DllPublic double CDecl GetJSPropertyAccessorAsDouble(JSContext* context, JSPropertyAccessor* accessor, JSObject* obj, JSRuntimeError* outError, JSScriptException** outScriptError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSPropertyAccessorAsInt")]
+/// public static extern int GetAsInt(JSContext context, JSPropertyAccessor accessor, JSObject obj, out JSRuntimeError error, out JSScriptException scriptError);
+DllPublic int CDecl GetJSPropertyAccessorAsInt(JSContext* context, JSPropertyAccessor* accessor, JSObject* obj, JSRuntimeError* outError, JSScriptException** outScriptError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSPropertyAccessorAsBool")]
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public static extern bool GetAsBool(JSContext context, JSPropertyAccessor accessor, JSObject obj, out JSRuntimeError error, out JSScriptException scriptError);
+DllPublic bool CDecl GetJSPropertyAccessorAsBool(JSContext* context, JSPropertyAccessor* accessor, JSObject* obj, JSRuntimeError* outError, JSScriptException** outScriptError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSPropertyAccessorDouble")]
+/// public static extern void SetDouble(JSContext context, JSPropertyAccessor accessor, JSObject obj, double value, out JSScriptException error);
+DllPublic void CDecl SetJSPropertyAccessorDouble(JSContext* context, JSPropertyAccessor* accessor, JSObject* obj, double value, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSPropertyAccessorInt")]
+/// public static extern void SetInt(JSContext context, JSPropertyAccessor accessor, JSObject obj, int value, out JSScriptException error);
+DllPublic void CDecl SetJSPropertyAccessorInt(JSContext* context, JSPropertyAccessor* accessor, JSObject* obj, int value, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSPropertyAccessorBool")]
+/// public static extern void SetBool(JSContext context, JSPropertyAccessor accessor, JSObject obj, [MarshalAs(UnmanagedType.I1)]bool value, out JSScriptException error);
+DllPublic void CDecl SetJSPropertyAccessorBool(JSContext* context, JSPropertyAccessor* accessor, JSObject* obj, bool value, JSScriptException** outError);
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // JSON
+/// public static class Json
+/// {
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSONParseUtf16Create")]
+/// public static extern JSValue ParseCreate(JSContext context, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string json, int length, out JSScriptException error);
+DllPublic JSValue* CDecl JSONParseUtf16Create(JSContext* context, const uint16_t* json, int length, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSONParseUtf8Create")]
+/// public static extern JSValue ParseUtf8Create(JSContext context, [In]byte[] json, int length, out JSScriptException error);
+DllPublic JSValue* CDecl JSONParseUtf8Create(JSContext* context, const char* json, int length, JSScriptException** outError);
+///// Returns the length of the JSON text in UTF-16 code units. The text is only
+///// written if it fits in bufferLength (it is not null terminated). Returns -1
+///// for values that JSON.stringify turns into undefined, such as functions.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSONStringifyUtf16")]
+/// public static extern int Stringify(JSContext context, JSValue value, [Out]char[] buffer, int bufferLength, out JSScriptException error);
+DllPublic int CDecl JSONStringifyUtf16(JSContext* context, JSValue* value, uint16_t* outBuffer, int bufferLength, JSScriptException** outError);
+///// Like JSONStringifyUtf16, but the length is in UTF-8 bytes.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSONStringifyUtf8")]
+/// public static extern int StringifyUtf8(JSContext context, JSValue value, [Out]byte[] buffer, int bufferLength, out JSScriptException error);
+DllPublic int CDecl JSONStringifyUtf8(JSContext* context, JSValue* value, char* outBuffer, int bufferLength, JSScriptException** outError);
+/// public static string Stringify(JSContext context, JSValue value, out JSScriptException error)
+/// {
+/// 	var buffer = new char[256];
+/// 	var length = Stringify(context, value, buffer, buffer.Length, out error);
+/// 	if (length < 0)
+/// 		return null;
+/// 	if (length > buffer.Length)
+/// 	{
+/// 		buffer = new char[length];
+/// 		length = Stringify(context, value, buffer, buffer.Length, out error);
+/// 	}
+/// 	return new string(buffer, 0, length);
+/// }
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Binary encoding
+///// Whole values are converted to and from MessagePack in one call. null and
+///// undefined become nil, numbers become ints (when they are int32s) or
+///// float64s, strings are UTF-8, ArrayBuffers and views are bin, Dates are
+///// timestamp extensions, arrays and Sets are arrays, and plain objects (own
+///// enumerable string keys) and Maps are maps. Functions and symbols can't be
+///// encoded.
+/// public static class Binary
+/// {
+///// Returns the number of bytes written. Values nested more than maxDepth
+///// levels, cyclic values and values that don't fit in bufferLength bytes
+///// fail with a RangeError or TypeError.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="EncodeJSValue")]
+/// public static extern int Encode(JSContext context, JSValue value, IntPtr buffer, int bufferLength, int maxDepth, out JSScriptException error);
+DllPublic int CDecl EncodeJSValue(JSContext* context, JSValue* value, void* outBuffer, int bufferLength, int maxDepth, JSScriptException** outError);
+///// Builds the value in one call. Besides what EncodeJSValue writes, all
+///// MessagePack int and float forms are accepted; 64-bit ints become doubles.
+///// Maps become plain objects, so their keys must be strings or non-negative
+///// integers.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="DecodeJSValueCreate")]
+/// public static extern JSValue DecodeCreate(JSContext context, IntPtr data, int length, int maxDepth, out JSScriptException error);
+DllPublic JSValue* CDecl DecodeJSValueCreate(JSContext* context, const void* data, int length, int maxDepth, JSScriptException** outError);
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Shapes
+///// A shape describes how the properties of objects with a fixed set of keys
+///// map onto the fields of a host struct: names[i] is stored as types[i] at
+///// byte offsets[i]. Keys are internalized when the shape is created, so a
+///// shape should be created once per context and reused. Reading converts
+///// property values like the corresponding typed array would (ToNumber, then
+///// wrapping for ints), so missing properties become 0 (or NaN).
+/// public static class Shape
+/// {
+///// Returns null and sets error to TypeError if a field doesn't fit in
+///// structSize bytes.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSShape")]
+/// public static extern JSShape Create(JSContext context, [In, MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPWStr)]string[] names, [In]JSFieldType[] types, [In]int[] offsets, int fieldCount, int structSize, out JSRuntimeError error);
+DllPublic JSShape* CDecl CreateJSShape(JSContext* context, const uint16_t* const* names, const JSFieldType* types, const int* offsets, int fieldCount, int structSize, JSRuntimeError* outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSShape")]
+/// public static extern void Release(JSContext context, JSShape shape);
+DllPublic void CDecl ReleaseJSShape(JSContext* context, JSShape* shape);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReadJSStruct")]
+/// public static extern void Read(JSContext context, JSShape shape, JSObject obj, IntPtr outStruct, out JSScriptException error);
+DllPublic void CDecl ReadJSStruct(JSContext* context, JSShape* shape, JSObject* obj, void* outStruct, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSStructObject")]
+/// public static extern JSObject CreateObject(JSContext context, JSShape shape, IntPtr data, out JSScriptException error);
+DllPublic JSObject* CDecl CreateJSStructObject(JSContext* context, JSShape* shape, const void* data, JSScriptException** outError);
+///// Reads the elements of arr into consecutive structs and returns the length
+///// of arr. Only the first capacity elements are read.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReadJSStructArray")]
+/// public static extern int ReadArray(JSContext context, JSShape shape, JSArray arr, IntPtr outStructs, int capacity, out JSScriptException error);
+DllPublic int CDecl ReadJSStructArray(JSContext* context, JSShape* shape, JSArray* arr, void* outStructs, int capacity, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSStructArray")]
+/// public static extern JSArray CreateArray(JSContext context, JSShape shape, IntPtr structs, int count, out JSScriptException error);
+DllPublic JSArray* CDecl CreateJSStructArray(JSContext* context, JSShape* shape, const void* structs, int count, JSScriptException** outError);
+/// }
+
 /// // -------------------------------------------------------------------------
 /// // Exceptions
 /// public static class ScriptException
@@ -341,4 +990,303 @@ DllPublic JSString* CDecl GetJSScriptExceptionStackTrace(JSScriptException* e);
 DllPublic JSString* CDecl GetJSScriptExceptionSourceLine(JSScriptException* e);
 /// }
 
+/// // -------------------------------------------------------------------------
+/// // Shared ring buffer
+///// A single-producer, single-consumer byte ring for streaming data between a
+///// host thread and a script through a SharedArrayBuffer. The memory layout is
+///// four int32s (head, tail, capacity, reserved), accessed atomically by both
+///// sides, followed by capacity data bytes; at most capacity - 1 bytes can be
+///// buffered. InstallJSRingBuffer defines a global
+///// SharedRingBuffer(sharedArrayBuffer) with available(), write(uint8Array)
+///// and read(uint8Array) methods for the script side.
+/// public static class RingBuffer
+/// {
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSRingBufferByteLength")]
+/// public static extern int ByteLength(int capacity);
+DllPublic int CDecl JSRingBufferByteLength(int capacity);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="InitializeJSRingBuffer")]
+/// public static extern void Initialize(IntPtr memory, int capacity);
+DllPublic void CDecl InitializeJSRingBuffer(void* memory, int capacity);
+///// byteLength is the size of the ring's memory. Returns the number of bytes
+///// written, which is less than length if the ring is full, or -1 if length is
+///// negative or the header is invalid (capacity not positive or larger than
+///// the memory, or head or tail outside [0, capacity)).
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSRingBuffer")]
+/// public static extern int Write(IntPtr memory, int byteLength, IntPtr data, int length);
+DllPublic int CDecl WriteJSRingBuffer(void* memory, int byteLength, const void* data, int length);
+///// Returns the number of bytes read, or -1 as for Write.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReadJSRingBuffer")]
+/// public static extern int Read(IntPtr memory, int byteLength, IntPtr outData, int length);
+DllPublic int CDecl ReadJSRingBuffer(void* memory, int byteLength, void* outData, int length);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="InstallJSRingBuffer")]
+/// public static extern void Install(JSContext context, out JSScriptException error);
+DllPublic void CDecl InstallJSRingBuffer(JSContext* context, JSScriptException** outError);
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Serialization
+///// Values are serialized with the structured clone algorithm, which keeps
+///// types like typed arrays, Maps, Sets and Dates. The format is the one used
+///// by V8's ValueSerializer.
+/// public static class Serializer
+/// {
+///// The ArrayBuffers in transfer (which may be null) are moved into the result
+///// and neutered, and can only be deserialized once. Objects with internal
+///// fields are passed to hostObjectWriter (which may be null, making them an
+///// error); the object it gets is only valid for the duration of the call.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SerializeJSValueCreate")]
+/// public static extern JSSerializedValue SerializeCreate(JSContext context, JSValue value, JSArray transfer, IntPtr hostData, [MarshalAs(UnmanagedType.FunctionPtr)]JSHostObjectWriter hostObjectWriter, out JSScriptException error);
+DllPublic JSSerializedValue* CDecl SerializeJSValueCreate(JSContext* context, JSValue* value, JSArray* transfer, void* hostData, JSHostObjectWriter hostObjectWriter, JSScriptException** outError);
+///// hostObjectReader returns a new reference, or null to fail.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="DeserializeJSValueCreate")]
+/// public static extern JSValue DeserializeCreate(JSContext context, JSSerializedValue serialized, IntPtr hostData, [MarshalAs(UnmanagedType.FunctionPtr)]JSHostObjectReader hostObjectReader, out JSScriptException error);
+DllPublic JSValue* CDecl DeserializeJSValueCreate(JSContext* context, JSSerializedValue* serialized, void* hostData, JSHostObjectReader hostObjectReader, JSScriptException** outError);
+///// Copies previously serialized bytes, e.g. read back from disk.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSSerializedValue")]
+/// public static extern JSSerializedValue Create(IntPtr data, int length);
+DllPublic JSSerializedValue* CDecl CreateJSSerializedValue(const void* data, int length);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSSerializedValue")]
+/// public static extern void Retain(JSSerializedValue serialized);
+DllPublic void CDecl RetainJSSerializedValue(JSSerializedValue* serialized);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSSerializedValue")]
+/// public static extern void Release(JSSerializedValue serialized);
+DllPublic void CDecl ReleaseJSSerializedValue(JSSerializedValue* serialized);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSerializedValueData")]
+/// public static extern IntPtr GetData(JSSerializedValue serialized);
+DllPublic const void* CDecl GetJSSerializedValueData(JSSerializedValue* serialized);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSerializedValueLength")]
+/// public static extern int GetLength(JSSerializedValue serialized);
+DllPublic int CDecl GetJSSerializedValueLength(JSSerializedValue* serialized);
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // WebAssembly
+///// Compiled modules can be cached on disk: serialize them into a
+///// JSSerializedValue (only used as a byte buffer here), save its data, and
+///// recreate it with CreateJSSerializedValue on the next run.
+/// public static class Wasm
+/// {
+///// Compiles the module synchronously, like new WebAssembly.Module(bytes).
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CompileJSWasmModule")]
+/// public static extern JSObject Compile(JSContext context, IntPtr bytes, int length, out JSScriptException error);
+DllPublic JSObject* CDecl CompileJSWasmModule(JSContext* context, const void* bytes, int length, JSScriptException** outError);
+///// Like new WebAssembly.Instance(module, imports). imports may be null. The
+///// module's exports are in the instance's exports property.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="InstantiateJSWasmModule")]
+/// public static extern JSObject Instantiate(JSContext context, JSObject module, JSObject imports, out JSScriptException error);
+DllPublic JSObject* CDecl InstantiateJSWasmModule(JSContext* context, JSObject* module, JSObject* imports, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SerializeJSWasmModuleCreate")]
+/// public static extern JSSerializedValue SerializeCreate(JSContext context, JSObject module, out JSScriptException error);
+DllPublic JSSerializedValue* CDecl SerializeJSWasmModuleCreate(JSContext* context, JSObject* module, JSScriptException** outError);
+///// Returns null, without an error, if the data was serialized by a different
+///// V8 build or with different flags; the module has to be compiled again.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="DeserializeJSWasmModule")]
+/// public static extern JSObject Deserialize(JSContext context, JSSerializedValue serialized, out JSScriptException error);
+DllPublic JSObject* CDecl DeserializeJSWasmModule(JSContext* context, JSSerializedValue* serialized, JSScriptException** outError);
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Worker
+///// A worker runs a script in its own context on its own thread. Messages are
+///// structured clones, passed through lock-free queues. In the worker, the
+///// global postMessage(value, transferList) replies to the host and incoming
+///// messages are passed to the global onmessage(value) function. Uncaught
+///// worker exceptions are delivered to the host as string messages flagged
+///// as errors.
+/// public static class Worker
+/// {
+///// The notifier is called on the worker thread whenever a message for the
+///// host has been queued.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSWorker")]
+/// public static extern JSWorker Create([MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 1)]string fileName, int fileNameLength, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 3)]string code, int codeLength, IntPtr notifierData, [MarshalAs(UnmanagedType.FunctionPtr)]JSWorkerMessageNotifier notifier);
+DllPublic JSWorker* CDecl CreateJSWorker(const uint16_t* fileName, int fileNameLength, const uint16_t* code, int codeLength, void* notifierData, JSWorkerMessageNotifier notifier);
+///// Terminates the worker's script if it is running and joins its thread. When
+///// called from the notifier, the thread finishes and frees the worker on its
+///// own after the notifier returns instead.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSWorker")]
+/// public static extern void Release(JSWorker worker);
+DllPublic void CDecl ReleaseJSWorker(JSWorker* worker);
+///// Any thread may post. The ArrayBuffers in transfer (which may be null) are
+///// moved to the worker and neutered in context.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="PostJSWorkerMessage")]
+/// public static extern void PostMessage(JSContext context, JSWorker worker, JSValue message, JSArray transfer, out JSScriptException error);
+DllPublic void CDecl PostJSWorkerMessage(JSContext* context, JSWorker* worker, JSValue* message, JSArray* transfer, JSScriptException** outError);
+///// Only one thread at a time may receive from a given worker. Returns false
+///// if there are no pending messages.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="TryReceiveJSWorkerMessage")]
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public static extern bool TryReceiveMessage(JSContext context, JSWorker worker, out JSValue message, [MarshalAs(UnmanagedType.I1)]out bool isError, out JSScriptException error);
+DllPublic bool CDecl TryReceiveJSWorkerMessage(JSContext* context, JSWorker* worker, JSValue** outMessage, bool* outIsError, JSScriptException** outError);
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Parallel map
+///// A pool of single-owner contexts, each on its own thread, that have all
+///// evaluated the same script once. A map calls the script's global function
+///// functionName(input, output, index) once per record, where input and output
+///// are DataViews of the record's bytes in the host buffers. Records are split
+///// into chunks that idle threads steal from busy ones.
+/// public static class ParallelPool
+/// {
+///// threadCount <= 0 uses one thread per core. Returns once all threads have
+///// evaluated the script; failures are reported through the error functions.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSParallelPool")]
+/// public static extern JSParallelPool Create(int threadCount, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string code, int codeLength, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 4)]string functionName, int functionNameLength);
+DllPublic JSParallelPool* CDecl CreateJSParallelPool(int threadCount, const uint16_t* code, int codeLength, const uint16_t* functionName, int functionNameLength);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSParallelPool")]
+/// public static extern void Release(JSParallelPool pool);
+DllPublic void CDecl ReleaseJSParallelPool(JSParallelPool* pool);
+///// Blocks until all records are processed. output may be null. Sets error to
+///// ScriptError if any call threw, with the first error of the map in the
+///// error functions. If the script itself threw, every map fails.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSParallelMap")]
+/// public static extern void Map(JSParallelPool pool, IntPtr input, int inputStride, IntPtr output, int outputStride, int count, out JSRuntimeError error);
+DllPublic void CDecl JSParallelMap(JSParallelPool* pool, const void* input, int inputStride, void* output, int outputStride, int count, JSRuntimeError* outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSParallelPoolErrorLength")]
+/// public static extern int ErrorLength(JSParallelPool pool);
+DllPublic int CDecl JSParallelPoolErrorLength(JSParallelPool* pool);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSParallelPoolErrorBuffer")]
+/// public static extern void WriteError(JSParallelPool pool, [Out, MarshalAs(UnmanagedType.LPWStr)]StringBuilder buffer, [MarshalAs(UnmanagedType.I1)]bool nullTerminate);
+DllPublic void CDecl WriteJSParallelPoolErrorBuffer(JSParallelPool* pool, uint16_t* outBuffer, bool nullTerminate);
+/// public static string GetError(JSParallelPool pool)
+/// {
+/// 	var sb = new StringBuilder(ErrorLength(pool) + 1);
+/// 	WriteError(pool, sb, true);
+/// 	return sb.ToString();
+/// }
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Stack sampler
+///// A sampler thread interrupts the contexts added to it while they are
+///// running script, and records their JS stacks into a ring of capacity
+///// samples, each at most maxFrames frames and maxStackLength bytes long. Older
+///// samples are overwritten. Contexts are sampled at most hz times a second
+///// (at least 1, at most 1000), and are retained until removed.
+/// public static class StackSampler
+/// {
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSStackSampler")]
+/// public static extern JSStackSampler Create(int capacity, int maxFrames, int maxStackLength);
+DllPublic JSStackSampler* CDecl CreateJSStackSampler(int capacity, int maxFrames, int maxStackLength);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSStackSampler")]
+/// public static extern void Release(JSStackSampler sampler);
+DllPublic void CDecl ReleaseJSStackSampler(JSStackSampler* sampler);
+///// Adding a context again changes its rate.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="AddJSStackSamplerContext")]
+/// public static extern void AddContext(JSStackSampler sampler, JSContext context, double hz);
+DllPublic void CDecl AddJSStackSamplerContext(JSStackSampler* sampler, JSContext* context, double hz);
+///// A removed context records no more samples, even for requests in flight.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RemoveJSStackSamplerContext")]
+/// public static extern void RemoveContext(JSStackSampler sampler, JSContext context);
+DllPublic void CDecl RemoveJSStackSamplerContext(JSStackSampler* sampler, JSContext* context);
+///// Forgets the samples recorded so far.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ClearJSStackSampler")]
+/// public static extern void Clear(JSStackSampler sampler);
+DllPublic void CDecl ClearJSStackSampler(JSStackSampler* sampler);
+///// Writes the samples in the folded format read by flame graph tools, one
+///// "frame;frame;frame count" line per distinct stack, as UTF-8. Returns the
+///// length in bytes; the text is only written if it fits in bufferLength.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSStackSamplerFolded")]
+/// public static extern int WriteFolded(JSStackSampler sampler, [Out]byte[] buffer, int bufferLength);
+DllPublic int CDecl WriteJSStackSamplerFolded(JSStackSampler* sampler, char* outBuffer, int bufferLength);
+/// public static string GetFolded(JSStackSampler sampler)
+/// {
+/// 	var buffer = new byte[4096];
+/// 	var length = WriteFolded(sampler, buffer, buffer.Length);
+/// 	while (length > buffer.Length)
+/// 	{
+/// 		buffer = new byte[length];
+/// 		length = WriteFolded(sampler, buffer, buffer.Length);
+/// 	}
+/// 	return Encoding.UTF8.GetString(buffer, 0, length);
+/// }
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Scheduler
+///// Runs work queued for many contexts on a fixed pool of threads, never more
+///// than one item per context at a time, and in each context in the order it
+///// was posted. Contexts take turns by the CPU share they have had, where
+///// work run at a higher priority is charged less of it, and a context whose
+///// next item has a higher priority gets an earlier turn. A busy context
+///// can't starve the others, and low priority work isn't starved either.
+///// Running script can't be suspended and moved, so an item that overruns its
+///// budget is terminated instead. The contexts must not be single-owner.
+/// public static class Scheduler
+/// {
+///// threadCount <= 0 uses one thread per core.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSScheduler")]
+/// public static extern JSScheduler Create(int threadCount);
+DllPublic JSScheduler* CDecl CreateJSScheduler(int threadCount);
+///// Terminates the running work and waits for it, then calls the work that
+///// never ran with cancelled set.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSScheduler")]
+/// public static extern void Release(JSScheduler scheduler);
+DllPublic void CDecl ReleaseJSScheduler(JSScheduler* scheduler);
+///// May be called from any thread. The work is called on a pool thread, with
+///// the context entered, or at once with cancelled set if the context is
+///// single-owner. Script it runs for longer than budgetMilliseconds
+///// (unless 0) is terminated, which surfaces as a script exception in the
+///// call that was running it.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="PostJSSchedulerWork")]
+/// public static extern void Post(JSScheduler scheduler, JSContext context, JSSchedulerPriority priority, int budgetMilliseconds, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSScheduledWork work);
+DllPublic void CDecl PostJSSchedulerWork(JSScheduler* scheduler, JSContext* context, JSSchedulerPriority priority, int budgetMilliseconds, void* data, JSScheduledWork work);
+///// The number of items waiting to run, in total or for one context.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSchedulerQueueDepth")]
+/// public static extern int GetQueueDepth(JSScheduler scheduler);
+DllPublic int CDecl GetJSSchedulerQueueDepth(JSScheduler* scheduler);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSchedulerContextQueueDepth")]
+/// public static extern int GetContextQueueDepth(JSScheduler scheduler, JSContext context);
+DllPublic int CDecl GetJSSchedulerContextQueueDepth(JSScheduler* scheduler, JSContext* context);
+///// The number of items that have started, and the total and longest times
+///// in nanoseconds they waited in the queue before starting.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSchedulerStartedCount")]
+/// public static extern ulong GetStartedCount(JSScheduler scheduler);
+DllPublic uint64_t CDecl GetJSSchedulerStartedCount(JSScheduler* scheduler);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSchedulerTotalWaitTime")]
+/// public static extern ulong GetTotalWaitTime(JSScheduler scheduler);
+DllPublic uint64_t CDecl GetJSSchedulerTotalWaitTime(JSScheduler* scheduler);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSchedulerMaxWaitTime")]
+/// public static extern ulong GetMaxWaitTime(JSScheduler scheduler);
+DllPublic uint64_t CDecl GetJSSchedulerMaxWaitTime(JSScheduler* scheduler);
+///// The number of items terminated for overrunning their budget.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSSchedulerTerminatedCount")]
+/// public static extern ulong GetTerminatedCount(JSScheduler scheduler);
+DllPublic uint64_t CDecl GetJSSchedulerTerminatedCount(JSScheduler* scheduler);
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Executor
+///// Lets any thread hand work to the thread that owns a context instead of
+///// taking the context's lock itself. Jobs go through a lock-free queue and
+///// are run by the owner thread when it pumps the executor, all under one
+///// entry into the context.
+/// public static class Executor
+/// {
+///// The notifier is called on the submitting thread after each submit, and
+///// should arrange for the owner thread to pump.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSExecutor")]
+/// public static extern JSExecutor Create(JSContext context, IntPtr notifierData, [MarshalAs(UnmanagedType.FunctionPtr)]JSExecutorNotifier notifier);
+DllPublic JSExecutor* CDecl CreateJSExecutor(JSContext* context, void* notifierData, JSExecutorNotifier notifier);
+///// Calls the jobs that never ran with cancelled set.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSExecutor")]
+/// public static extern void Release(JSExecutor executor);
+DllPublic void CDecl ReleaseJSExecutor(JSExecutor* executor);
+///// Any thread may submit. The work is called with the context entered.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SubmitJSExecutorWork")]
+/// public static extern void SubmitWork(JSExecutor executor, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSScheduledWork work);
+DllPublic void CDecl SubmitJSExecutorWork(JSExecutor* executor, void* data, JSScheduledWork work);
+///// Any thread may submit. The script is evaluated and the completion is
+///// called with its result or error, which the completion must release.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SubmitJSExecutorScript")]
+/// public static extern void SubmitScript(JSExecutor executor, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string fileName, int fileNameLength, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 4)]string code, int codeLength, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSExecutorCompletion completion);
+DllPublic void CDecl SubmitJSExecutorScript(JSExecutor* executor, const uint16_t* fileName, int fileNameLength, const uint16_t* code, int codeLength, void* data, JSExecutorCompletion completion);
+///// Runs up to maxJobs queued jobs (all of them if maxJobs <= 0) and returns
+///// the number run, or -1 if the context is single-owner and this isn't its
+///// owner thread. Only one thread at a time may pump a given executor.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="PumpJSExecutor")]
+/// public static extern int Pump(JSExecutor executor, int maxJobs);
+DllPublic int CDecl PumpJSExecutor(JSExecutor* executor, int maxJobs);
+/// }
+
 /// }
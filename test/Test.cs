@@ -213,7 +213,9 @@ public class V8SimpleTests
 			var arr = Value.CopyOwnPropertyNames(context, obj, out err);
 			CheckError(context, err);
 			var properties = new HashSet<string>();
-			var len = Value.Length(context, arr);
+			JSRuntimeError rtErr;
+			var len = Value.Length(context, arr, out rtErr);
+			CheckError(rtErr);
 			for (int i = 0; i < len; ++i)
 			{
 				var prop = Value.CopyProperty(context, arr, i, out err);
@@ -227,9 +229,11 @@ public class V8SimpleTests
 			Assert.IsFalse(properties.Contains("d"));
 		}
 		{
-			Assert.IsTrue(Value.StrictEquals(context, Value.AsValue(obj), Value.AsValue(obj)));
+			JSRuntimeError rtErr;
+			Assert.IsTrue(Value.StrictEquals(context, Value.AsValue(obj), Value.AsValue(obj), out rtErr));
+			CheckError(rtErr);
 			var obj2 = AsObject(Eval(context, testName, "({ a: \"abc\", b: 123 })"));
-			Assert.IsFalse(Value.StrictEquals(context, Value.AsValue(obj), Value.AsValue(obj2)));
+			Assert.IsFalse(Value.StrictEquals(context, Value.AsValue(obj), Value.AsValue(obj2), out rtErr));
 			Value.Release(context, Value.AsValue(obj2));
 		}
 
@@ -250,7 +254,9 @@ public class V8SimpleTests
 	{
 		var context = Context.Create(null, null);
 		var arr = AsArray(Eval(context, "Arrays", "[\"abc\", 123]"));
-		Assert.AreEqual(2, Value.Length(context, arr));
+		JSRuntimeError rtErr;
+		Assert.AreEqual(2, Value.Length(context, arr, out rtErr));
+		CheckError(rtErr);
 		JSScriptException err;
 		var a = Value.CopyProperty(context, arr, 0, out err);
 		CheckError(context, err);
@@ -321,7 +327,10 @@ public class V8SimpleTests
 
 	static JSExternal CreateExternal(JSContext context, object o)
 	{
-		return Value.CreateExternal(context, GCHandle.ToIntPtr(GCHandle.Alloc(o)));
+		JSRuntimeError err;
+		var result = Value.CreateExternal(context, GCHandle.ToIntPtr(GCHandle.Alloc(o)), out err);
+		CheckError(err);
+		return result;
 	}
 
 	static void FinalizeCallback(IntPtr data)
@@ -449,12 +458,17 @@ public class V8SimpleTests
 	{
 		_messageHandler = (data, message) => { return; };
 		var context = Context.Create(null, null);
-		Debug.SetMessageHandler(context, IntPtr.Zero, null);
-		Debug.ProcessMessages(context);
+		JSRuntimeError err;
+		Debug.SetMessageHandler(context, IntPtr.Zero, null, out err);
+		CheckError(err);
+		Debug.ProcessMessages(context, out err);
+		CheckError(err);
 
-		Debug.SetMessageHandler(context, IntPtr.Zero, _messageHandler);
+		Debug.SetMessageHandler(context, IntPtr.Zero, _messageHandler, out err);
+		CheckError(err);
 		Debug.SendCommand(context, "{}", 2);
-		Debug.ProcessMessages(context);
+		Debug.ProcessMessages(context, out err);
+		CheckError(err);
 
 		Context.Release(context);
 	}
@@ -563,8 +577,10 @@ public class V8SimpleTests
 
 		var ext = CreateExternal(context, someObject);
 
+		JSRuntimeError rtErr;
 		{
-			var val = GCHandle.FromIntPtr(Value.GetExternalValue(context, ext)).Target as SomeObject;
+			var val = GCHandle.FromIntPtr(Value.GetExternalValue(context, ext, out rtErr)).Target as SomeObject;
+			CheckError(rtErr);
 			Assert.AreEqual(someObject, val);
 		}
 		{
@@ -580,7 +596,8 @@ public class V8SimpleTests
 				out err);
 			CheckError(context, err);
 
-			var val = GCHandle.FromIntPtr(Value.GetExternalValue(context, AsExternal(ext2))).Target as SomeObject;
+			var val = GCHandle.FromIntPtr(Value.GetExternalValue(context, AsExternal(ext2), out rtErr)).Target as SomeObject;
+			CheckError(rtErr);
 			Assert.AreEqual(someObject, val);
 
 			Value.Release(context, ext2);
@@ -632,9 +649,10 @@ public class V8SimpleTests
 		{
 			var marshaller = new ArrayMarshaller(buf);
 
-			var arrayBuffer = Value.CreateExternalArrayBuffer(context, marshaller.GetIntPtr(), len);
-
 			JSRuntimeError err;
+			var arrayBuffer = Value.CreateExternalArrayBuffer(context, marshaller.GetIntPtr(), len, out err);
+			CheckError(err);
+
 			Assert.AreEqual(marshaller.GetIntPtr(), Value.GetArrayBufferData(context, arrayBuffer, out err));
 			CheckError(err);
 
@@ -666,4 +684,1144 @@ public class V8SimpleTests
 
 		Context.Release(context);
 	}
+
+	[Test]
+	public void SingleOwner()
+	{
+		var testName = "SingleOwner";
+		var context = Context.CreateSingleOwner(null, null);
+		{
+			var result = Eval(context, testName, "12 + 13");
+			Assert.AreEqual(25, AsInt(result));
+			Value.Release(context, result);
+		}
+		{
+			var f = AsFunction(Eval(context, testName, "(function(x) { return x + \"!\"; })"));
+			var arg = AsJSString(context, "abc");
+			JSScriptException err;
+			var result = Value.CallCreate(context, f, default(JSObject), new JSValue[] { Value.AsValue(arg) }, 1, out err);
+			CheckError(context, err);
+			Assert.AreEqual("abc!", AsString(context, result));
+			Value.Release(context, result);
+			Value.Release(context, Value.AsValue(arg));
+			Value.Release(context, Value.AsValue(f));
+		}
+		{
+			// Other threads get errors instead of touching the context, and their
+			// releases are carried out by the owner
+			var value = Eval(context, testName, "({})");
+			Context.Retain(context);
+			JSRuntimeError rtErr = JSRuntimeError.NoError;
+			JSRuntimeError globalErr = JSRuntimeError.NoError;
+			JSScriptException err = default(JSScriptException);
+			string message = null;
+			var thread = new System.Threading.Thread(() =>
+			{
+				Value.CreateString(context, "x", 1, out rtErr);
+				Context.CopyGlobalObject(context, out globalErr);
+				var errors = new JSScriptException[1];
+				Context.EvaluateBatch(context, new[] { testName }, new[] { "1" }, 1, false, errors);
+				err = errors[0];
+				message = Value.ToString(context, ScriptException.GetMessage(err));
+				Value.Release(context, value);
+				Context.Release(context);
+			});
+			thread.Start();
+			thread.Join();
+			Assert.AreEqual(JSRuntimeError.WrongThread, rtErr);
+			Assert.AreEqual(JSRuntimeError.WrongThread, globalErr);
+			Assert.AreNotEqual(default(JSScriptException), err);
+			Assert.AreEqual("Context used from a thread other than its owner", message);
+			Assert.AreEqual(message, AsString(context, Value.AsValue(ScriptException.GetMessage(err))));
+			ScriptException.Release(context, err);
+			Value.Release(context, Eval(context, testName, "0"));
+		}
+		{
+			// The last reference to a context released by another thread is
+			// released by the owner the next time it uses one of its contexts
+			var finalized = false;
+			JSExternalFinalizer finalizer = data => { finalized = true; };
+			var other = Context.CreateSingleOwner(null, finalizer);
+			JSRuntimeError rtErr;
+			Snapshot.BindHostObject(other, 0, new IntPtr(1), out rtErr);
+			CheckError(rtErr);
+			var thread = new System.Threading.Thread(() => Context.Release(other));
+			thread.Start();
+			thread.Join();
+			Assert.IsFalse(finalized);
+			Value.Release(context, Eval(context, testName, "0"));
+			Assert.IsTrue(finalized);
+			GC.KeepAlive(finalizer);
+		}
+		Context.Release(context);
+	}
+
+	[Test]
+	public void Workers()
+	{
+		var context = Context.Create(null, null);
+		var code = "onmessage = function(m) { postMessage({ sum: m.x + m.y, bytes: new Uint8Array(m.buffer)[3] }); };";
+		var worker = Worker.Create("Workers", "Workers".Length, code, code.Length, IntPtr.Zero, null);
+
+		var message = AsObject(Eval(context, "Workers", "({ x: 12, y: 13, buffer: new Uint8Array([0, 1, 2, 3]).buffer })"));
+		JSScriptException err;
+		Worker.PostMessage(context, worker, Value.AsValue(message), default(JSArray), out err);
+		CheckError(context, err);
+
+		JSValue reply = default(JSValue);
+		bool isError = false;
+		var received = false;
+		for (int i = 0; i < 500 && !received; ++i)
+		{
+			received = Worker.TryReceiveMessage(context, worker, out reply, out isError, out err);
+			CheckError(context, err);
+			if (!received)
+				System.Threading.Thread.Sleep(10);
+		}
+		Assert.IsTrue(received);
+		Assert.IsFalse(isError);
+
+		var replyObject = AsObject(reply);
+		var sum = AsJSString(context, "sum");
+		var bytes = AsJSString(context, "bytes");
+		var sumValue = Value.CopyProperty(context, replyObject, sum, out err);
+		CheckError(context, err);
+		Assert.AreEqual(25, AsInt(sumValue));
+		var bytesValue = Value.CopyProperty(context, replyObject, bytes, out err);
+		CheckError(context, err);
+		Assert.AreEqual(3, AsInt(bytesValue));
+
+		Value.Release(context, bytesValue);
+		Value.Release(context, sumValue);
+		Value.Release(context, Value.AsValue(bytes));
+		Value.Release(context, Value.AsValue(sum));
+		Value.Release(context, reply);
+		Value.Release(context, Value.AsValue(message));
+		Worker.Release(worker);
+		Context.Release(context);
+	}
+
+	[Test]
+	public void WorkerReleasedFromNotifier()
+	{
+		var code = "postMessage(1);";
+		var created = new System.Threading.ManualResetEvent(false);
+		var released = new System.Threading.ManualResetEvent(false);
+		var worker = default(JSWorker);
+		JSWorkerMessageNotifier notifier = data =>
+		{
+			created.WaitOne();
+			Worker.Release(worker);
+			released.Set();
+		};
+		worker = Worker.Create("WorkerReleasedFromNotifier", "WorkerReleasedFromNotifier".Length, code, code.Length, IntPtr.Zero, notifier);
+		created.Set();
+		Assert.IsTrue(released.WaitOne(5000));
+		GC.KeepAlive(notifier);
+	}
+
+	[Test]
+	public void Serialization()
+	{
+		var testName = "Serialization";
+		var context1 = Context.Create(null, null);
+		var context2 = Context.Create(null, null);
+		JSScriptException err;
+
+		var value = Eval(context1, testName, "({ a: [1, 2.5, \"x\"], m: new Map([[1, \"one\"]]), d: new Date(5), t: new Float64Array([4.5]) })");
+		var serialized = Serializer.SerializeCreate(context1, value, default(JSArray), IntPtr.Zero, null, out err);
+		CheckError(context1, err);
+		Value.Release(context1, value);
+
+		var bytes = new byte[Serializer.GetLength(serialized)];
+		Marshal.Copy(Serializer.GetData(serialized), bytes, 0, bytes.Length);
+		Serializer.Release(serialized);
+
+		var marshaller = new ArrayMarshaller(bytes);
+		var copy = Serializer.Create(marshaller.GetIntPtr(), bytes.Length);
+		var result = Serializer.DeserializeCreate(context2, copy, IntPtr.Zero, null, out err);
+		CheckError(context2, err);
+		Serializer.Release(copy);
+
+		var check = AsFunction(Eval(context2, testName, "(function(v) { return v.a[1] === 2.5 && v.a[2] === \"x\" && v.m.get(1) === \"one\" && v.d.getTime() === 5 && v.t[0] === 4.5; })"));
+		var checkResult = Value.CallCreate(context2, check, default(JSObject), new JSValue[] { result }, 1, out err);
+		CheckError(context2, err);
+		Assert.IsTrue(AsBool(checkResult));
+
+		Value.Release(context2, checkResult);
+		Value.Release(context2, Value.AsValue(check));
+		Value.Release(context2, result);
+		Context.Release(context2);
+		Context.Release(context1);
+	}
+
+	[Test]
+	public void ParallelMap()
+	{
+		var code = "function square(input, output, index) { output.setFloat64(0, input.getFloat64(0, true) * input.getFloat64(0, true), true); }";
+		var pool = ParallelPool.Create(4, code, code.Length, "square", "square".Length);
+		Assert.AreEqual(0, ParallelPool.ErrorLength(pool));
+
+		var count = 10000;
+		var input = new double[count];
+		var output = new double[count];
+		for (int i = 0; i < count; ++i)
+			input[i] = i;
+
+		var inputHandle = GCHandle.Alloc(input, GCHandleType.Pinned);
+		var outputHandle = GCHandle.Alloc(output, GCHandleType.Pinned);
+		JSRuntimeError err;
+		ParallelPool.Map(pool, inputHandle.AddrOfPinnedObject(), sizeof(double), outputHandle.AddrOfPinnedObject(), sizeof(double), count, out err);
+		outputHandle.Free();
+		inputHandle.Free();
+		CheckError(err);
+
+		for (int i = 0; i < count; ++i)
+			Assert.AreEqual((double)i * i, output[i]);
+
+		ParallelPool.Release(pool);
+	}
+
+	[Test]
+	public void ParallelMapAfterFailure()
+	{
+		var code = "function square(input, output, index) { var x = input.getFloat64(0, true); if (x < 0) throw new Error(\"negative\"); output.setFloat64(0, x * x, true); }";
+		var pool = ParallelPool.Create(2, code, code.Length, "square", "square".Length);
+		var input = new double[] { 1, -1, 3 };
+		var output = new double[input.Length];
+		var inputHandle = GCHandle.Alloc(input, GCHandleType.Pinned);
+		var outputHandle = GCHandle.Alloc(output, GCHandleType.Pinned);
+		JSRuntimeError err;
+		ParallelPool.Map(pool, inputHandle.AddrOfPinnedObject(), sizeof(double), outputHandle.AddrOfPinnedObject(), sizeof(double), input.Length, out err);
+		Assert.AreEqual(JSRuntimeError.ScriptError, err);
+		StringAssert.Contains("negative", ParallelPool.GetError(pool));
+
+		// A failed map doesn't fail the ones after it
+		input[1] = 2;
+		ParallelPool.Map(pool, inputHandle.AddrOfPinnedObject(), sizeof(double), outputHandle.AddrOfPinnedObject(), sizeof(double), input.Length, out err);
+		outputHandle.Free();
+		inputHandle.Free();
+		CheckError(err);
+		Assert.AreEqual(0, ParallelPool.ErrorLength(pool));
+		Assert.AreEqual(new double[] { 1, 4, 9 }, output);
+
+		ParallelPool.Release(pool);
+	}
+
+	[Test]
+	public void SharedRingBuffer()
+	{
+		var testName = "SharedRingBuffer";
+		var context = Context.Create(null, null);
+		JSScriptException err;
+		RingBuffer.Install(context, out err);
+		CheckError(context, err);
+
+		var capacity = 64;
+		var memory = new byte[RingBuffer.ByteLength(capacity)];
+		var marshaller = new ArrayMarshaller(memory);
+		RingBuffer.Initialize(marshaller.GetIntPtr(), capacity);
+
+		JSRuntimeError rtErr;
+		var sab = Value.CreateExternalSharedArrayBuffer(context, marshaller.GetIntPtr(), memory.Length, out rtErr);
+		CheckError(rtErr);
+		var f = AsFunction(Eval(context, testName,
+			"(function(sab) { var ring = new SharedRingBuffer(sab); var bytes = new Uint8Array(ring.available()); ring.read(bytes); " +
+			"var sum = 0; for (var i = 0; i < bytes.length; ++i) sum += bytes[i]; ring.write(new Uint8Array([sum])); return Atomics.load(new Int32Array(sab), 2); })"));
+
+		var input = new byte[] { 1, 2, 3, 4, 5 };
+		var inputMarshaller = new ArrayMarshaller(input);
+		Assert.AreEqual(input.Length, RingBuffer.Write(marshaller.GetIntPtr(), memory.Length, inputMarshaller.GetIntPtr(), input.Length));
+
+		var result = Value.CallCreate(context, f, default(JSObject), new JSValue[] { Value.AsValue(sab) }, 1, out err);
+		CheckError(context, err);
+		Assert.AreEqual(capacity, AsInt(result));
+
+		var output = new byte[4];
+		var outputMarshaller = new ArrayMarshaller(output);
+		Assert.AreEqual(1, RingBuffer.Read(marshaller.GetIntPtr(), memory.Length, outputMarshaller.GetIntPtr(), output.Length));
+		Assert.AreEqual(15, output[0]);
+
+		// Invalid arguments and headers are rejected
+		Assert.AreEqual(-1, RingBuffer.Write(marshaller.GetIntPtr(), memory.Length, inputMarshaller.GetIntPtr(), -1));
+		Assert.AreEqual(-1, RingBuffer.Read(marshaller.GetIntPtr(), memory.Length, outputMarshaller.GetIntPtr(), -1));
+		Array.Copy(BitConverter.GetBytes(capacity), 0, memory, 0, 4);
+		Assert.AreEqual(-1, RingBuffer.Write(marshaller.GetIntPtr(), memory.Length, inputMarshaller.GetIntPtr(), input.Length));
+		Assert.AreEqual(-1, RingBuffer.Read(marshaller.GetIntPtr(), memory.Length, outputMarshaller.GetIntPtr(), output.Length));
+		Array.Copy(BitConverter.GetBytes(0), 0, memory, 0, 4);
+		Array.Copy(BitConverter.GetBytes(0), 0, memory, 8, 4);
+		Assert.AreEqual(-1, RingBuffer.Write(marshaller.GetIntPtr(), memory.Length, inputMarshaller.GetIntPtr(), input.Length));
+		Assert.AreEqual(-1, RingBuffer.Write(marshaller.GetIntPtr(), RingBuffer.ByteLength(0), inputMarshaller.GetIntPtr(), input.Length));
+
+		// A capacity larger than the memory, as a script could set, is rejected
+		var corrupt = AsFunction(Eval(context, testName,
+			"(function(sab) { var header = new Int32Array(sab); Atomics.store(header, 0, 0); Atomics.store(header, 1, 0); Atomics.store(header, 2, 0x7fffffff); })"));
+		var corruptResult = Value.CallCreate(context, corrupt, default(JSObject), new JSValue[] { Value.AsValue(sab) }, 1, out err);
+		CheckError(context, err);
+		Assert.AreEqual(-1, RingBuffer.Write(marshaller.GetIntPtr(), memory.Length, inputMarshaller.GetIntPtr(), input.Length));
+		Assert.AreEqual(-1, RingBuffer.Read(marshaller.GetIntPtr(), memory.Length, outputMarshaller.GetIntPtr(), output.Length));
+		Value.Release(context, corruptResult);
+		Value.Release(context, Value.AsValue(corrupt));
+
+		Value.Release(context, result);
+		Value.Release(context, Value.AsValue(f));
+		Value.Release(context, Value.AsValue(sab));
+		Context.Release(context);
+	}
+
+	[Test]
+	public void Json()
+	{
+		var context = Context.Create(null, null);
+		JSScriptException err;
+		{
+			var json = "{\"a\":[1,2.5,\"x\"],\"b\":{\"c\":true}}";
+			var value = Fuse.Scripting.V8.Simple.Json.ParseCreate(context, json, json.Length, out err);
+			CheckError(context, err);
+			Assert.AreEqual(json, Fuse.Scripting.V8.Simple.Json.Stringify(context, value, out err));
+			CheckError(context, err);
+
+			var utf8 = new byte[4];
+			var length = Fuse.Scripting.V8.Simple.Json.StringifyUtf8(context, value, utf8, utf8.Length, out err);
+			CheckError(context, err);
+			Assert.AreEqual(Encoding.UTF8.GetByteCount(json), length);
+			utf8 = new byte[length];
+			Fuse.Scripting.V8.Simple.Json.StringifyUtf8(context, value, utf8, utf8.Length, out err);
+			CheckError(context, err);
+			Assert.AreEqual(json, Encoding.UTF8.GetString(utf8));
+			Value.Release(context, value);
+		}
+		{
+			var utf8 = Encoding.UTF8.GetBytes("\"\u00e6\u00f8\u00e5\"");
+			var value = Fuse.Scripting.V8.Simple.Json.ParseUtf8Create(context, utf8, utf8.Length, out err);
+			CheckError(context, err);
+			Assert.AreEqual("\u00e6\u00f8\u00e5", AsString(context, value));
+			Assert.AreEqual("\"\u00e6\u00f8\u00e5\"", Fuse.Scripting.V8.Simple.Json.Stringify(context, value, out err));
+			CheckError(context, err);
+			Value.Release(context, value);
+		}
+		{
+			var json = "{ not json";
+			var value = Fuse.Scripting.V8.Simple.Json.ParseCreate(context, json, json.Length, out err);
+			Assert.AreNotEqual(default(JSScriptException), err);
+			Assert.AreEqual(default(JSValue), value);
+			ScriptException.Release(context, err);
+		}
+		foreach (var code in new[] { "(function() { })", "({ toJSON: function() { } })" })
+		{
+			var value = Eval(context, "Json", code);
+			Assert.AreEqual(null, Fuse.Scripting.V8.Simple.Json.Stringify(context, value, out err));
+			CheckError(context, err);
+			var utf8 = new byte[16];
+			Assert.AreEqual(-1, Fuse.Scripting.V8.Simple.Json.StringifyUtf8(context, value, utf8, utf8.Length, out err));
+			CheckError(context, err);
+			Value.Release(context, value);
+		}
+		Context.Release(context);
+	}
+
+	[Test]
+	public void BinaryEncoding()
+	{
+		var testName = "BinaryEncoding";
+		var context = Context.Create(null, null);
+		JSScriptException err;
+		var buffer = new byte[64];
+		var marshaller = new ArrayMarshaller(buffer);
+		{
+			var value = Eval(context, testName, "({ a: 1, b: [true, null], c: \"x\", d: -200, e: 0.5, f: 200, g: 40000 })");
+			var length = Binary.Encode(context, value, marshaller.GetIntPtr(), buffer.Length, 16, out err);
+			CheckError(context, err);
+			var expected = new byte[]
+			{
+				0x87,
+				0xa1, (byte)'a', 0x01,
+				0xa1, (byte)'b', 0x92, 0xc3, 0xc0,
+				0xa1, (byte)'c', 0xa1, (byte)'x',
+				0xa1, (byte)'d', 0xd1, 0xff, 0x38,
+				0xa1, (byte)'e', 0xcb, 0x3f, 0xe0, 0, 0, 0, 0, 0, 0,
+				0xa1, (byte)'f', 0xcc, 0xc8,
+				0xa1, (byte)'g', 0xcd, 0x9c, 0x40,
+			};
+			Assert.AreEqual(expected.Length, length);
+			for (int i = 0; i < expected.Length; ++i)
+				Assert.AreEqual(expected[i], buffer[i]);
+			Value.Release(context, value);
+		}
+		{
+			var value = Eval(context, testName, "(function() { var o = { x: [] }; o.x.push(o); return o; })()");
+			Binary.Encode(context, value, marshaller.GetIntPtr(), buffer.Length, 16, out err);
+			Assert.AreNotEqual(default(JSScriptException), err);
+			ScriptException.Release(context, err);
+			Value.Release(context, value);
+		}
+		{
+			var value = Eval(context, testName, "new Array(100).join(\"x\")");
+			Binary.Encode(context, value, marshaller.GetIntPtr(), buffer.Length, 16, out err);
+			Assert.AreNotEqual(default(JSScriptException), err);
+			ScriptException.Release(context, err);
+			Value.Release(context, value);
+		}
+		Context.Release(context);
+	}
+
+	[Test]
+	public void BinaryDecoding()
+	{
+		var context = Context.Create(null, null);
+		JSScriptException err;
+		{
+			var data = new byte[]
+			{
+				0x83,
+				0xa1, (byte)'a', 0x92, 0x81, 0xa1, (byte)'k', 0xcd, 0x01, 0x00, 0x81, 0xa1, (byte)'k', 0xff,
+				0xa1, (byte)'b', 0xcb, 0x3f, 0xe0, 0, 0, 0, 0, 0, 0,
+				0xa1, (byte)'c', 0xc3,
+			};
+			var marshaller = new ArrayMarshaller(data);
+			var value = Binary.DecodeCreate(context, marshaller.GetIntPtr(), data.Length, 16, out err);
+			CheckError(context, err);
+			Assert.AreEqual("{\"a\":[{\"k\":256},{\"k\":-1}],\"b\":0.5,\"c\":true}", Fuse.Scripting.V8.Simple.Json.Stringify(context, value, out err));
+			CheckError(context, err);
+			Value.Release(context, value);
+		}
+		foreach (var data in new[]
+		{
+			new byte[] { 0x92, 0x01 },
+			// Counts larger than the input is long are rejected up front
+			new byte[] { 0xdd, 0x7f, 0xff, 0xff, 0xff },
+			new byte[] { 0xdf, 0x7f, 0xff, 0xff, 0xff },
+		})
+		{
+			var marshaller = new ArrayMarshaller(data);
+			Binary.DecodeCreate(context, marshaller.GetIntPtr(), data.Length, 16, out err);
+			Assert.AreNotEqual(default(JSScriptException), err);
+			ScriptException.Release(context, err);
+		}
+		Context.Release(context);
+	}
+
+	[Test]
+	public void Shapes()
+	{
+		var testName = "Shapes";
+		var context = Context.Create(null, null);
+		JSScriptException err;
+		JSRuntimeError rtErr;
+		var shape = Shape.Create(
+			context,
+			new string[] { "x", "y", "visible" },
+			new JSFieldType[] { JSFieldType.Double, JSFieldType.Int32, JSFieldType.Bool },
+			new int[] { 0, 8, 12 },
+			3,
+			16,
+			out rtErr);
+		Assert.AreEqual(JSRuntimeError.NoError, rtErr);
+		var structs = new byte[32];
+		var marshaller = new ArrayMarshaller(structs);
+		{
+			var arr = AsArray(Eval(context, testName, "[{ x: 1.5, y: -3, visible: true }, { x: 2, y: 7 }]"));
+			Assert.AreEqual(2, Shape.ReadArray(context, shape, arr, marshaller.GetIntPtr(), 2, out err));
+			CheckError(context, err);
+			Assert.AreEqual(1.5, BitConverter.ToDouble(structs, 0));
+			Assert.AreEqual(-3, BitConverter.ToInt32(structs, 8));
+			Assert.AreEqual(1, structs[12]);
+			Assert.AreEqual(2.0, BitConverter.ToDouble(structs, 16));
+			Assert.AreEqual(7, BitConverter.ToInt32(structs, 24));
+			Assert.AreEqual(0, structs[28]);
+			Value.Release(context, Value.AsValue(arr));
+		}
+		{
+			var arr = Shape.CreateArray(context, shape, marshaller.GetIntPtr(), 2, out err);
+			CheckError(context, err);
+			Assert.AreEqual(
+				"[{\"x\":1.5,\"y\":-3,\"visible\":true},{\"x\":2,\"y\":7,\"visible\":false}]",
+				Fuse.Scripting.V8.Simple.Json.Stringify(context, Value.AsValue(arr), out err));
+			CheckError(context, err);
+			Value.Release(context, Value.AsValue(arr));
+		}
+		Assert.AreEqual(default(JSShape), Shape.Create(context, new string[] { "x" }, new JSFieldType[] { JSFieldType.Double }, new int[] { 12 }, 1, 16, out rtErr));
+		Assert.AreEqual(JSRuntimeError.TypeError, rtErr);
+		Shape.Release(context, shape);
+		Context.Release(context);
+	}
+
+	[Test]
+	public void ObjectEntries()
+	{
+		var testName = "ObjectEntries";
+		var context = Context.Create(null, null);
+		JSScriptException err;
+		var obj = AsObject(Eval(context, testName, "({ a: 1, \u00e6: \"x\", 7: true })"));
+		{
+			var entries = Entries.Copy(context, obj, false, out err);
+			CheckError(context, err);
+			Assert.AreEqual(3, Entries.Count(entries));
+			CollectionAssert.AreEqual(new string[] { "7", "a", "\u00e6" }, Entries.GetKeys(entries));
+			var values = new JSValue[3];
+			Entries.CopyValues(entries, values);
+			Assert.IsTrue(AsBool(values[0]));
+			Assert.AreEqual(1, AsInt(values[1]));
+			Assert.AreEqual("x", AsString(context, values[2]));
+			foreach (var value in values)
+				Value.Release(context, value);
+			Entries.Release(context, entries);
+		}
+		{
+			var entries = Entries.Copy(context, obj, true, out err);
+			CheckError(context, err);
+			Assert.AreEqual(5, Entries.KeysLength(entries));
+			var keys = new byte[5];
+			var keyEnds = new int[3];
+			Entries.WriteKeysUtf8(entries, keys, keyEnds);
+			CollectionAssert.AreEqual(new int[] { 1, 2, 4 }, keyEnds);
+			Assert.AreEqual("7a\u00e6", Encoding.UTF8.GetString(keys));
+			Entries.Release(context, entries);
+		}
+		{
+			var cursor = Entries.CreateCursor(context, obj, out err);
+			CheckError(context, err);
+			var keys = new List<string>();
+			while (true)
+			{
+				var entries = Entries.CopyNext(context, cursor, 2, false, out err);
+				CheckError(context, err);
+				if (entries.Equals(default(JSEntries)))
+					break;
+				keys.AddRange(Entries.GetKeys(entries));
+				Entries.Release(context, entries);
+			}
+			CollectionAssert.AreEqual(new string[] { "7", "a", "\u00e6" }, keys);
+			Entries.ReleaseCursor(context, cursor);
+		}
+		Value.Release(context, Value.AsValue(obj));
+		Context.Release(context);
+	}
+
+	[Test]
+	public void MapsAndSets()
+	{
+		var testName = "MapsAndSets";
+		var context = Context.Create(null, null);
+		JSScriptException err;
+		JSRuntimeError rtErr;
+		{
+			var value = Eval(context, testName, "new Map([[\"a\", 1], [2, \"b\"]])");
+			Assert.AreEqual(JSType.Map, Value.GetType(value));
+			var map = Value.AsObject(value, out rtErr);
+			Assert.AreEqual(JSRuntimeError.NoError, rtErr);
+			Assert.AreEqual(2, Value.MapSize(context, map, out rtErr));
+			CheckError(rtErr);
+			var keys = new JSValue[2];
+			var values = new JSValue[2];
+			Assert.AreEqual(2, Value.CopyMapEntries(context, map, keys, values, 2, out err));
+			CheckError(context, err);
+			Assert.AreEqual("a", AsString(context, keys[0]));
+			Assert.AreEqual(1, AsInt(values[0]));
+			Assert.AreEqual(2, AsInt(keys[1]));
+			Assert.AreEqual("b", AsString(context, values[1]));
+			Value.CopyMapEntries(context, map, keys, values, -1, out err);
+			Assert.AreNotEqual(default(JSScriptException), err);
+			ScriptException.Release(context, err);
+			Value.CreateMap(context, keys, values, -1, out err);
+			Assert.AreNotEqual(default(JSScriptException), err);
+			ScriptException.Release(context, err);
+
+			var copy = Value.CreateMap(context, keys, values, 2, out err);
+			CheckError(context, err);
+			var get = AsFunction(Eval(context, testName, "(function(m) { return m.get(2); })"));
+			var result = Value.CallCreate(context, get, default(JSObject), new JSValue[] { Value.AsValue(copy) }, 1, out err);
+			CheckError(context, err);
+			Assert.AreEqual("b", AsString(context, result));
+
+			Value.Release(context, result);
+			Value.Release(context, Value.AsValue(get));
+			Value.Release(context, Value.AsValue(copy));
+			for (int i = 0; i < 2; ++i)
+			{
+				Value.Release(context, keys[i]);
+				Value.Release(context, values[i]);
+			}
+			Value.Release(context, value);
+		}
+		{
+			var values = new JSValue[] { Value.CreateInt(3), Value.CreateInt(3), Value.CreateBool(true) };
+			var set = Value.CreateSet(context, values, values.Length, out err);
+			CheckError(context, err);
+			Assert.AreEqual(JSType.Set, Value.GetType(Value.AsValue(set)));
+			Assert.AreEqual(2, Value.SetSize(context, set, out rtErr));
+			CheckError(rtErr);
+			var copied = new JSValue[1];
+			Assert.AreEqual(2, Value.CopySetValues(context, set, copied, 1, out err));
+			CheckError(context, err);
+			Assert.AreEqual(3, AsInt(copied[0]));
+			Value.Release(context, copied[0]);
+			Assert.AreEqual(0, Value.CopyMapEntries(context, set, copied, copied, 1, out err));
+			Assert.AreNotEqual(default(JSScriptException), err);
+			ScriptException.Release(context, err);
+			Value.Release(context, Value.AsValue(set));
+			foreach (var value in values)
+				Value.Release(context, value);
+		}
+		Context.Release(context);
+	}
+
+	[Test]
+	public void ArrayCursors()
+	{
+		var testName = "ArrayCursors";
+		var context = Context.Create(null, null);
+		JSScriptException err;
+		var arr = AsArray(Eval(context, testName, "[1, 2.5, true, null, \"s\", {}]"));
+		JSRuntimeError rtErr;
+		var cursor = ArrayCursor.Create(context, arr, out rtErr);
+		CheckError(rtErr);
+		var types = new JSType[4];
+		var numbers = new double[4];
+		var values = new JSValue[4];
+		Assert.AreEqual(4, ArrayCursor.CopyNext(context, cursor, types, numbers, values, 4, out err));
+		CheckError(context, err);
+		CollectionAssert.AreEqual(new JSType[] { JSType.Int, JSType.Double, JSType.Bool, JSType.Null }, types);
+		CollectionAssert.AreEqual(new double[] { 1, 2.5, 1, 0 }, numbers);
+		Assert.AreEqual(2, ArrayCursor.CopyNext(context, cursor, types, numbers, values, 4, out err));
+		CheckError(context, err);
+		Assert.AreEqual(JSType.String, types[0]);
+		Assert.AreEqual("s", AsString(context, values[0]));
+		Assert.AreEqual(JSType.Object, types[1]);
+		Value.Release(context, values[0]);
+		Value.Release(context, values[1]);
+		Assert.AreEqual(0, ArrayCursor.CopyNext(context, cursor, types, numbers, values, 4, out err));
+		CheckError(context, err);
+
+		// Only the thread holding the cursor's lock may use or release it
+		var otherCount = -1;
+		var otherErr = default(JSScriptException);
+		var otherRtErr = JSRuntimeError.NoError;
+		var other = new System.Threading.Thread(() =>
+		{
+			otherCount = ArrayCursor.CopyNext(context, cursor, types, numbers, values, 4, out otherErr);
+			ArrayCursor.Release(context, cursor, out otherRtErr);
+		});
+		other.Start();
+		other.Join();
+		Assert.AreEqual(0, otherCount);
+		Assert.AreNotEqual(default(JSScriptException), otherErr);
+		Assert.AreEqual(JSRuntimeError.WrongThread, otherRtErr);
+		ScriptException.Release(context, otherErr);
+
+		ArrayCursor.Release(context, cursor, out rtErr);
+		CheckError(rtErr);
+		Value.Release(context, Value.AsValue(arr));
+		Context.Release(context);
+	}
+
+	[Test]
+	public void TypedGetters()
+	{
+		var testName = "TypedGetters";
+		var context = Context.Create(null, null);
+		JSScriptException err;
+		JSRuntimeError rtErr;
+		var obj = AsObject(Eval(context, testName, "({ d: 1.5, i: 3, b: true, s: \"str\" })"));
+		var d = AsJSString(context, "d");
+		var i = AsJSString(context, "i");
+		var b = AsJSString(context, "b");
+		var str = AsJSString(context, "s");
+		Assert.AreEqual(1.5, Value.GetPropertyAsDouble(context, obj, d, out rtErr, out err));
+		Assert.AreEqual(JSRuntimeError.NoError, rtErr);
+		CheckError(context, err);
+		Assert.AreEqual(3.0, Value.GetPropertyAsDouble(context, obj, i, out rtErr, out err));
+		Assert.AreEqual(3, Value.GetPropertyAsInt(context, obj, i, out rtErr, out err));
+		Assert.AreEqual(JSRuntimeError.NoError, rtErr);
+		Assert.IsTrue(Value.GetPropertyAsBool(context, obj, b, out rtErr, out err));
+		Assert.AreEqual(JSRuntimeError.NoError, rtErr);
+		Assert.AreEqual("str", Value.GetPropertyAsString(context, obj, str, out rtErr, out err));
+		Assert.AreEqual(JSRuntimeError.NoError, rtErr);
+		Assert.AreEqual(0, Value.GetPropertyAsInt(context, obj, d, out rtErr, out err));
+		Assert.AreEqual(JSRuntimeError.InvalidCast, rtErr);
+		CheckError(context, err);
+
+		var arr = AsArray(Eval(context, testName, "[7, \"x\"]"));
+		Assert.AreEqual(7, Value.GetPropertyAsInt(context, arr, 0, out rtErr, out err));
+		Assert.AreEqual(JSRuntimeError.NoError, rtErr);
+		var buffer = new char[1];
+		Assert.AreEqual(1, Value.GetPropertyAsString(context, arr, 1, buffer, buffer.Length, out rtErr, out err));
+		Assert.AreEqual('x', buffer[0]);
+		Value.GetPropertyAsBool(context, arr, 1, out rtErr, out err);
+		Assert.AreEqual(JSRuntimeError.InvalidCast, rtErr);
+
+		foreach (var key in new JSString[] { d, i, b, str })
+			Value.Release(context, Value.AsValue(key));
+		Value.Release(context, Value.AsValue(arr));
+		Value.Release(context, Value.AsValue(obj));
+		Context.Release(context);
+	}
+
+	[Test]
+	public void TypedSetters()
+	{
+		var testName = "TypedSetters";
+		var context = Context.Create(null, null);
+		JSScriptException err;
+		var obj = AsObject(Eval(context, testName, "({})"));
+		var d = AsJSString(context, "d");
+		var i = AsJSString(context, "i");
+		var b = AsJSString(context, "b");
+		var str = AsJSString(context, "s");
+		Value.SetPropertyDouble(context, obj, d, 0.25, out err);
+		CheckError(context, err);
+		Value.SetPropertyInt(context, obj, i, -4, out err);
+		CheckError(context, err);
+		Value.SetPropertyBool(context, obj, b, false, out err);
+		CheckError(context, err);
+		var utf8 = Encoding.UTF8.GetBytes("\u00e6");
+		Value.SetPropertyUtf8(context, obj, str, utf8, utf8.Length, out err);
+		CheckError(context, err);
+		Assert.AreEqual(
+			"{\"d\":0.25,\"i\":-4,\"b\":false,\"s\":\"\u00e6\"}",
+			Fuse.Scripting.V8.Simple.Json.Stringify(context, Value.AsValue(obj), out err));
+
+		var arr = AsArray(Eval(context, testName, "[]"));
+		Value.SetPropertyInt(context, arr, 1, 5, out err);
+		CheckError(context, err);
+		Value.SetPropertyDouble(context, arr, 0, 1.5, out err);
+		CheckError(context, err);
+		Assert.AreEqual("[1.5,5]", Fuse.Scripting.V8.Simple.Json.Stringify(context, Value.AsValue(arr), out err));
+
+		foreach (var key in new JSString[] { d, i, b, str })
+			Value.Release(context, Value.AsValue(key));
+		Value.Release(context, Value.AsValue(arr));
+		Value.Release(context, Value.AsValue(obj));
+		Context.Release(context);
+	}
+
+	[Test]
+	public void PropertyAccessors()
+	{
+		var testName = "PropertyAccessors";
+		var context = Context.Create(null, null);
+		JSScriptException err;
+		JSRuntimeError rtErr;
+		var accessor = PropertyAccessor.Create(context, "x", 1, out rtErr);
+		CheckError(rtErr);
+		var objs = AsArray(Eval(context, testName, "[{ x: 1 }, { y: 0, x: 2.5 }]"));
+		var first = AsObject(Value.CopyProperty(context, objs, 0, out err));
+		var second = AsObject(Value.CopyProperty(context, objs, 1, out err));
+		Assert.AreEqual(1, PropertyAccessor.GetAsInt(context, accessor, first, out rtErr, out err));
+		Assert.AreEqual(JSRuntimeError.NoError, rtErr);
+		Assert.AreEqual(2.5, PropertyAccessor.GetAsDouble(context, accessor, second, out rtErr, out err));
+		Assert.AreEqual(JSRuntimeError.NoError, rtErr);
+		PropertyAccessor.SetInt(context, accessor, second, 3, out err);
+		CheckError(context, err);
+		var value = PropertyAccessor.CopyValue(context, accessor, second, out err);
+		CheckError(context, err);
+		Assert.AreEqual(3, AsInt(value));
+		PropertyAccessor.SetValue(context, accessor, first, value, out err);
+		CheckError(context, err);
+		Assert.AreEqual("[{\"x\":3},{\"y\":0,\"x\":3}]", Fuse.Scripting.V8.Simple.Json.Stringify(context, Value.AsValue(objs), out err));
+		Value.Release(context, value);
+		Value.Release(context, Value.AsValue(first));
+		Value.Release(context, Value.AsValue(second));
+		Value.Release(context, Value.AsValue(objs));
+		PropertyAccessor.Release(context, accessor);
+		Context.Release(context);
+	}
+
+	[Test]
+	public void EngineProfiles()
+	{
+		var testName = "EngineProfiles";
+		// The engine is configured once per process, so this only succeeds when
+		// no other test has created a context yet, e.g. when run on its own.
+		// Doing it here rather than for the fixture keeps the profile from
+		// applying to every other test.
+		var configured = Context.ConfigureEngine(JSEngineProfile.LowMemory, "--allow-natives-syntax");
+		var context = Context.Create(null, null);
+		Assert.IsFalse(Context.ConfigureEngine(JSEngineProfile.LowMemory, null));
+		// Natives syntax only parses if the flags given with the profile reached V8
+		if (configured)
+			Assert.AreEqual("number", AsString(context, Eval(context, testName, "typeof %GetOptimizationStatus(function() { })")));
+		JSRuntimeError err;
+		Context.SetRAILMode(context, JSRAILMode.Load, out err);
+		CheckError(err);
+		Assert.AreEqual(3, AsInt(Eval(context, testName, "1 + 2")));
+		Context.SetRAILMode(context, JSRAILMode.Animation, out err);
+		CheckError(err);
+		Context.Release(context);
+	}
+
+	[Test]
+	public void BackgroundContexts()
+	{
+		var testName = "BackgroundContexts";
+		var context = Context.Create(null, null);
+		JSRuntimeError err;
+		Context.SetInBackground(context, true, out err);
+		CheckError(err);
+		Context.NotifyMemoryPressure(JSMemoryPressure.Moderate);
+		Assert.AreEqual(3, AsInt(Eval(context, testName, "[1, 2].reduce(function(a, b) { return a + b; })")));
+		Context.SetInBackground(context, false, out err);
+		CheckError(err);
+		Context.NotifyMemoryPressure(context, JSMemoryPressure.None);
+		Context.Release(context);
+	}
+
+	[Test]
+	public void WarmSnapshots()
+	{
+		var testName = "WarmSnapshots";
+		var embedded = "var answer = 42; function twice(x) { return 2 * x; }";
+		var warmup = "twice(answer);";
+		var path = System.IO.Path.GetTempFileName();
+		Assert.IsTrue(Snapshot.WriteWarmFile(embedded, warmup, path));
+		var data = System.IO.File.ReadAllBytes(path);
+		System.IO.File.Delete(path);
+		var snapshot = Snapshot.CreateFromData(data, data.Length);
+		Assert.AreEqual(data.Length, Snapshot.GetLength(snapshot));
+		var context = Context.CreateFromSnapshot(null, null, snapshot);
+		Snapshot.Release(snapshot);
+		Assert.AreEqual(84, AsInt(Eval(context, testName, "twice(answer)")));
+		Context.Release(context);
+
+		Assert.AreEqual(default(JSSnapshot), Snapshot.Create("throw new Error()"));
+	}
+
+	[Test]
+	public void HostSnapshots()
+	{
+		var testName = "HostSnapshots";
+		JSScriptException err;
+		JSRuntimeError rtErr;
+		Func<JSContext, JSValue[], JSValue> inc = (cxt, args) => Value.CreateInt(AsInt(args[0]) + 1);
+		JSSnapshot snapshot;
+		{
+			var context = Snapshot.CreateContext(_callbackFinalizer, _externalFinalizer);
+			Snapshot.BindHostFunction(context, 0, GCHandle.ToIntPtr(GCHandle.Alloc(inc)), _callCallback, out rtErr);
+			var fun = Snapshot.CreateHostFunction(context, 0, out err);
+			CheckError(context, err);
+			var obj = Snapshot.CreateHostObject(context, 1, out err);
+			CheckError(context, err);
+			var global = Context.CopyGlobalObject(context, out rtErr);
+			var incKey = AsJSString(context, "inc");
+			var thingKey = AsJSString(context, "thing");
+			Value.SetProperty(context, global, incKey, Value.AsValue(fun), out err);
+			CheckError(context, err);
+			Value.SetProperty(context, global, thingKey, Value.AsValue(obj), out err);
+			CheckError(context, err);
+			Assert.AreEqual(2, AsInt(Eval(context, testName, "var two = inc(1); two")));
+			// Refused while the host still holds values from the context
+			Assert.AreEqual(default(JSSnapshot), Snapshot.CreateFromContext(context, false, out rtErr));
+			foreach (var value in new JSValue[] { Value.AsValue(fun), Value.AsValue(obj), Value.AsValue(global), Value.AsValue(incKey), Value.AsValue(thingKey) })
+				Value.Release(context, value);
+			snapshot = Snapshot.CreateFromContext(context, false, out rtErr);
+			CheckError(rtErr);
+			Assert.AreNotEqual(default(JSSnapshot), snapshot);
+			Context.Release(context);
+		}
+		{
+			var context = Context.CreateFromSnapshot(_callbackFinalizer, _externalFinalizer, snapshot);
+			Snapshot.Release(snapshot);
+			Eval(context, testName, "inc(1)", out err);
+			Assert.AreNotEqual(default(JSScriptException), err);
+			ScriptException.Release(context, err);
+
+			Snapshot.BindHostFunction(context, 0, GCHandle.ToIntPtr(GCHandle.Alloc(inc)), _callCallback, out rtErr);
+			Assert.AreEqual(3, AsInt(Eval(context, testName, "inc(two)")));
+
+			var thing = AsObject(Eval(context, testName, "thing"));
+			Assert.AreEqual(1u, Snapshot.GetHostObjectId(context, thing, out rtErr));
+			Assert.AreEqual(JSRuntimeError.NoError, rtErr);
+			Assert.AreEqual(IntPtr.Zero, Snapshot.GetHostObjectValue(context, thing, out rtErr));
+			var value = GCHandle.ToIntPtr(GCHandle.Alloc("bound"));
+			Snapshot.BindHostObject(context, 1, value, out rtErr);
+			Assert.AreEqual(value, Snapshot.GetHostObjectValue(context, thing, out rtErr));
+			Value.Release(context, Value.AsValue(thing));
+			Context.Release(context);
+		}
+	}
+
+	[Test]
+	public void WasmModules()
+	{
+		var context = Context.Create(null, null);
+		JSScriptException err;
+		// An empty module, in the binary format version this V8 reads
+		var bytes = new byte[] { 0x00, 0x61, 0x73, 0x6d, 0x0d, 0x00, 0x00, 0x00 };
+		var marshaller = new ArrayMarshaller(bytes);
+		var module = Wasm.Compile(context, marshaller.GetIntPtr(), bytes.Length, out err);
+		CheckError(context, err);
+		var serialized = Wasm.SerializeCreate(context, module, out err);
+		CheckError(context, err);
+		Assert.Greater(Serializer.GetLength(serialized), 0);
+		var cached = Wasm.Deserialize(context, serialized, out err);
+		CheckError(context, err);
+		Assert.AreNotEqual(default(JSObject), cached);
+		var instance = Wasm.Instantiate(context, cached, default(JSObject), out err);
+		CheckError(context, err);
+		Assert.AreNotEqual(default(JSObject), instance);
+
+		var garbage = new byte[] { 1, 2, 3 };
+		var garbageMarshaller = new ArrayMarshaller(garbage);
+		Wasm.Compile(context, garbageMarshaller.GetIntPtr(), garbage.Length, out err);
+		Assert.AreNotEqual(default(JSScriptException), err);
+		ScriptException.Release(context, err);
+
+		Serializer.Release(serialized);
+		Value.Release(context, Value.AsValue(instance));
+		Value.Release(context, Value.AsValue(cached));
+		Value.Release(context, Value.AsValue(module));
+		Context.Release(context);
+	}
+
+	[Test]
+	public void StackSampling()
+	{
+		var context = Context.Create(null, null);
+		var sampler = StackSampler.Create(256, 16, 512);
+		Assert.AreEqual("", StackSampler.GetFolded(sampler));
+		StackSampler.AddContext(sampler, context, 1000);
+		Value.Release(context, Eval(context, "busy.js",
+			"function spin(end) { while (Date.now() < end) {} }\n" +
+			"function outer() { spin(Date.now() + 200); }\n" +
+			"outer(); 0"));
+		var folded = StackSampler.GetFolded(sampler);
+		StringAssert.Contains("outer (busy.js:2);spin (busy.js:1)", folded);
+		StackSampler.Clear(sampler);
+		Assert.AreEqual("", StackSampler.GetFolded(sampler));
+		StackSampler.RemoveContext(sampler, context);
+		StackSampler.Release(sampler);
+		Context.Release(context);
+	}
+
+	[Test]
+	public void CpuAccounting()
+	{
+		JSScriptException err;
+		var context = Context.Create(_callbackFinalizer, _externalFinalizer);
+		Value.Release(context, Eval(context, "warm", "0"));
+		Assert.AreEqual(0UL, Context.GetCpuTime(context));
+
+		Context.SetCpuAccounting(context, true);
+		var f = AsFunction(Eval(context, "CpuAccounting",
+			"(function(f) { var end = Date.now() + 50; while (Date.now() < end) {} return f(); })"));
+		var cb = CreateCallback(context, (cxt, args) =>
+		{
+			var watch = System.Diagnostics.Stopwatch.StartNew();
+			while (watch.ElapsedMilliseconds < 50) {}
+			return Value.CreateInt(1);
+		});
+		var result = Value.CallCreate(context, f, default(JSObject), new JSValue[] { Value.AsValue(cb) }, 1, out err);
+		CheckError(context, err);
+		Assert.AreEqual(1, AsInt(result));
+
+		var total = Context.GetCpuTime(context);
+		var host = Context.GetHostCpuTime(context);
+		Assert.Greater(host, 10000000UL);
+		Assert.Greater(total - host, 10000000UL);
+
+		Context.SetCpuAccounting(context, false);
+		Context.ResetCpuTime(context);
+		Assert.AreEqual(0UL, Context.GetHostCpuTime(context));
+
+		Value.Release(context, result);
+		Value.Release(context, Value.AsValue(cb));
+		Value.Release(context, Value.AsValue(f));
+		Context.Release(context);
+	}
+
+	static void RunScheduledWork(IntPtr data, JSContext context, bool cancelled)
+	{
+		var handle = GCHandle.FromIntPtr(data);
+		var work = handle.Target as Action<JSContext, bool>;
+		handle.Free();
+		work(context, cancelled);
+	}
+
+	readonly JSScheduledWork _scheduledWork = RunScheduledWork;
+
+	[Test]
+	public void Scheduler()
+	{
+		var scheduler = Fuse.Scripting.V8.Simple.Scheduler.Create(2);
+		var contexts = new[] { Context.Create(null, null), Context.Create(null, null), Context.Create(null, null) };
+		var results = new int[contexts.Length];
+		var done = new System.Threading.CountdownEvent(contexts.Length * 10 + 1);
+		for (int i = 0; i < 10; ++i)
+		{
+			for (int c = 0; c < contexts.Length; ++c)
+			{
+				var index = c;
+				Action<JSContext, bool> work = (context, cancelled) =>
+				{
+					if (!cancelled)
+						results[index] = AsInt(Eval(context, "Scheduler", "var n = (typeof n === 'number' ? n : 0) + 1; n"));
+					done.Signal();
+				};
+				var priority = c == 0 ? JSSchedulerPriority.High : JSSchedulerPriority.Normal;
+				Fuse.Scripting.V8.Simple.Scheduler.Post(scheduler, contexts[c], priority, 0, GCHandle.ToIntPtr(GCHandle.Alloc(work)), _scheduledWork);
+			}
+		}
+
+		JSScriptException overrun = default(JSScriptException);
+		Action<JSContext, bool> spin = (context, cancelled) =>
+		{
+			Eval(context, "Spin", "while (true) {}", out overrun);
+			done.Signal();
+		};
+		Fuse.Scripting.V8.Simple.Scheduler.Post(scheduler, contexts[0], JSSchedulerPriority.Low, 50, GCHandle.ToIntPtr(GCHandle.Alloc(spin)), _scheduledWork);
+
+		Assert.IsTrue(done.Wait(10000));
+		CollectionAssert.AreEqual(new[] { 10, 10, 10 }, results);
+		Assert.AreNotEqual(default(JSScriptException), overrun);
+		ScriptException.Release(contexts[0], overrun);
+		Assert.AreEqual(1UL, Fuse.Scripting.V8.Simple.Scheduler.GetTerminatedCount(scheduler));
+		Assert.AreEqual(31UL, Fuse.Scripting.V8.Simple.Scheduler.GetStartedCount(scheduler));
+		Assert.AreEqual(0, Fuse.Scripting.V8.Simple.Scheduler.GetQueueDepth(scheduler));
+		Assert.GreaterOrEqual(
+			Fuse.Scripting.V8.Simple.Scheduler.GetTotalWaitTime(scheduler),
+			Fuse.Scripting.V8.Simple.Scheduler.GetMaxWaitTime(scheduler));
+
+		Fuse.Scripting.V8.Simple.Scheduler.Release(scheduler);
+		foreach (var context in contexts)
+			Context.Release(context);
+	}
+
+	static int _executorNotifications;
+
+	static void NotifyExecutor(IntPtr data)
+	{
+		System.Threading.Interlocked.Increment(ref _executorNotifications);
+	}
+
+	readonly JSExecutorNotifier _executorNotifier = NotifyExecutor;
+
+	static void CompleteExecutorScript(IntPtr data, JSContext context, JSValue result, JSScriptException error, bool cancelled)
+	{
+		var handle = GCHandle.FromIntPtr(data);
+		var completion = handle.Target as Action<JSContext, JSValue, JSScriptException, bool>;
+		handle.Free();
+		completion(context, result, error, cancelled);
+	}
+
+	readonly JSExecutorCompletion _executorCompletion = CompleteExecutorScript;
+
+	[Test]
+	public void Executors()
+	{
+		var context = Context.Create(null, null);
+		var executor = Executor.Create(context, IntPtr.Zero, _executorNotifier);
+		_executorNotifications = 0;
+
+		var ran = 0;
+		var submitters = new System.Threading.Thread[4];
+		for (int t = 0; t < submitters.Length; ++t)
+		{
+			submitters[t] = new System.Threading.Thread(() =>
+			{
+				for (int i = 0; i < 25; ++i)
+				{
+					Action<JSContext, bool> work = (cxt, cancelled) =>
+					{
+						Value.Release(cxt, Eval(cxt, "Executors", "var count = (typeof count === 'number' ? count : 0) + 1; count"));
+						++ran;
+					};
+					Executor.SubmitWork(executor, GCHandle.ToIntPtr(GCHandle.Alloc(work)), _scheduledWork);
+				}
+			});
+			submitters[t].Start();
+		}
+		foreach (var submitter in submitters)
+			submitter.Join();
+		Assert.AreEqual(100, _executorNotifications);
+
+		var count = 0;
+		Action<JSContext, JSValue, JSScriptException, bool> completion = (cxt, result, error, cancelled) =>
+		{
+			Assert.IsFalse(cancelled);
+			Assert.AreEqual(default(JSScriptException), error);
+			count = AsInt(result);
+		};
+		var code = "count";
+		Executor.SubmitScript(executor, "count.js", 8, code, code.Length, GCHandle.ToIntPtr(GCHandle.Alloc(completion)), _executorCompletion);
+
+		Assert.AreEqual(10, Executor.Pump(executor, 10));
+		Assert.AreEqual(91, Executor.Pump(executor, 0));
+		Assert.AreEqual(0, Executor.Pump(executor, 0));
+		Assert.AreEqual(100, ran);
+		Assert.AreEqual(100, count);
+
+		var cancelledWork = false;
+		Action<JSContext, bool> pending = (cxt, cancelled) => { cancelledWork = cancelled; };
+		Executor.SubmitWork(executor, GCHandle.ToIntPtr(GCHandle.Alloc(pending)), _scheduledWork);
+		Executor.Release(executor);
+		Assert.IsTrue(cancelledWork);
+		Context.Release(context);
+	}
+
+	[Test]
+	public void BatchEvaluation()
+	{
+		var context = Context.Create(null, null);
+		var fileNames = new[] { "a.js", "b.js", "c.js" };
+		var codes = new[] { "var a = 1;", "a = 2; throw new Error('b');", "var c = 3;" };
+		var errors = new JSScriptException[codes.Length];
+
+		Assert.AreEqual(1, Context.EvaluateBatch(context, fileNames, codes, codes.Length, false, errors));
+		Assert.AreEqual(default(JSScriptException), errors[0]);
+		Assert.AreNotEqual(default(JSScriptException), errors[1]);
+		Assert.AreEqual(default(JSScriptException), errors[2]);
+		ScriptException.Release(context, errors[1]);
+		Assert.AreEqual(2, AsInt(Eval(context, "BatchEvaluation", "a")));
+		Assert.AreEqual("undefined", AsString(context, Eval(context, "BatchEvaluation", "typeof c")));
+
+		Assert.AreEqual(1, Context.EvaluateBatch(context, fileNames, codes, codes.Length, true, errors));
+		Assert.AreNotEqual(default(JSScriptException), errors[1]);
+		ScriptException.Release(context, errors[1]);
+		Assert.AreEqual(3, AsInt(Eval(context, "BatchEvaluation", "c")));
+
+		Assert.AreEqual(-1, Context.EvaluateBatch(context, new[] { "d.js" }, new[] { "c + 1" }, 1, false, errors));
+		Assert.AreEqual(-2, Context.EvaluateBatch(context, fileNames, codes, -1, false, errors));
+		Context.Release(context);
+	}
+
+	[Test]
+	public void SchedulerPriorities()
+	{
+		var scheduler = Fuse.Scripting.V8.Simple.Scheduler.Create(1);
+		var contexts = new JSContext[4];
+		for (int i = 0; i < contexts.Length; ++i)
+			contexts[i] = Context.Create(null, null);
+		var order = new List<string>();
+		var release = new System.Threading.ManualResetEvent(false);
+		var done = new System.Threading.CountdownEvent(1 + 2 * 5 + 1);
+		Action<JSContext, JSSchedulerPriority, IntPtr> post = (context, priority, data) =>
+			Fuse.Scripting.V8.Simple.Scheduler.Post(scheduler, context, priority, 0, data, _scheduledWork);
+		Func<string, IntPtr> record = name =>
+		{
+			Action<JSContext, bool> work = (context, cancelled) => { lock (order) order.Add(name); done.Signal(); };
+			return GCHandle.ToIntPtr(GCHandle.Alloc(work));
+		};
+
+		// Keep the only pool thread busy while the backlog builds up
+		Action<JSContext, bool> block = (context, cancelled) => { release.WaitOne(); done.Signal(); };
+		post(contexts[0], JSSchedulerPriority.Normal, GCHandle.ToIntPtr(GCHandle.Alloc(block)));
+		while (Fuse.Scripting.V8.Simple.Scheduler.GetStartedCount(scheduler) == 0)
+			System.Threading.Thread.Sleep(1);
+		for (int i = 0; i < 5; ++i)
+		{
+			post(contexts[1], JSSchedulerPriority.Low, record("low"));
+			post(contexts[2], JSSchedulerPriority.Low, record("low"));
+		}
+		post(contexts[3], JSSchedulerPriority.High, record("high"));
+		Assert.AreEqual(11, Fuse.Scripting.V8.Simple.Scheduler.GetQueueDepth(scheduler));
+		release.Set();
+
+		Assert.IsTrue(done.Wait(10000));
+		Assert.AreEqual("high", order[0]);
+		Assert.AreEqual(11, order.Count);
+
+		Fuse.Scripting.V8.Simple.Scheduler.Release(scheduler);
+		foreach (var context in contexts)
+			Context.Release(context);
+	}
 }